@@ -0,0 +1,547 @@
+// CheckedArithmetic.h : Checked<T> add/subtract with overflow detection, shared by the
+// numeric overflow module and its benchmarks.
+//
+// add_numbers / subtract_numbers compute start +/- step * steps and stop before the first
+// step that would overflow (ok == false, value = last safe value); integral types use an
+// O(1) closed form, floating point steps one at a time. checked_add / checked_sub /
+// checked_sum apply the same contract to whole spans, and checked_add_sticky /
+// checked_sum_sticky test the floating point overflow flag once per batch.
+//
+
+#pragma once
+
+#include <algorithm>      // std::min
+#include <cfenv>          // std::feclearexcept, std::fetestexcept (sticky overflow flags)
+#include <cmath>          // std::isfinite, std::isnormal, std::fabs
+#include <cstddef>        // std::size_t
+#include <cstdint>        // std::uint64_t
+#include <limits>         // std::numeric_limits
+#include <span>           // std::span (batch APIs, C++20)
+#include <type_traits>    // std::is_integral_v, std::is_floating_point_v, std::is_signed_v, std::make_unsigned_t
+
+// A small return type to communicate both the numeric value and whether the operation was safe.
+// ok == true means no overflow or underflow occurred.
+// ok == false means we detected an impending overflow/underflow and stopped before it happened.
+// value is the last safe value we could compute.
+template <typename T>
+struct Checked {
+    T value{};
+    bool ok{ true };
+};
+
+/*
+    Helper: check if a + b would overflow or underflow for integral T.
+    This uses classic "add will overflow if a > max - b" style rules.
+*/
+template <typename T>
+inline bool will_add_overflow_integral(T a, T b) {
+    static_assert(std::is_integral_v<T>, "integral only");
+    using Lim = std::numeric_limits<T>;
+    if constexpr (std::is_signed_v<T>) {
+        if (b > 0 && a > Lim::max() - b) return true;
+        if (b < 0 && a < Lim::min() - b) return true;
+        return false;
+    }
+    else {
+        // unsigned
+        return a > Lim::max() - b; // b cannot be negative for unsigned
+    }
+}
+
+/*
+    Helper: check if a - b would overflow or underflow for integral T.
+    Implemented via addition check by negating b when signed.
+*/
+template <typename T>
+inline bool will_sub_overflow_integral(T a, T b) {
+    static_assert(std::is_integral_v<T>, "integral only");
+    if constexpr (std::is_signed_v<T>) {
+        return will_add_overflow_integral<T>(a, static_cast<T>(-b));
+    }
+    else {
+        // For unsigned, a - b underflows if b > a
+        return b > a;
+    }
+}
+
+/*
+    Helper: for floating point we treat overflow if the next value is not finite
+    or its magnitude exceeds the type's max. Tiny subnormal values are allowed;
+    if you want to treat loss of normal as underflow, we mark ok=false but still
+    provide the computed value (which may be 0 due to flush-to-zero on some targets).
+*/
+template <typename T>
+inline bool add_would_overflow_floating(T a, T b) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    long double trial = static_cast<long double>(a) + static_cast<long double>(b);
+    if (!std::isfinite(trial)) return true;
+    long double m = static_cast<long double>(std::numeric_limits<T>::max());
+    return std::fabs(trial) > m;
+}
+
+template <typename T>
+inline bool sub_would_overflow_floating(T a, T b) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    long double trial = static_cast<long double>(a) - static_cast<long double>(b);
+    if (!std::isfinite(trial)) return true;
+    long double m = static_cast<long double>(std::numeric_limits<T>::max());
+    return std::fabs(trial) > m;
+}
+
+/*
+    Helper: floating point add/subtract checked in T itself, without widening.
+    IEEE arithmetic rounds an out-of-range result to +/-infinity, so the operation is
+    done once and std::isfinite (an exponent-bits test) on the result is the whole check.
+    The result is handed back so the caller does not compute it a second time.
+    The long double helpers above are kept as the widened reference.
+*/
+template <typename T>
+inline bool checked_add_floating(T a, T b, T& result) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    result = static_cast<T>(a + b);
+    return std::isfinite(result);
+}
+
+template <typename T>
+inline bool checked_sub_floating(T a, T b, T& result) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    result = static_cast<T>(a - b);
+    return std::isfinite(result);
+}
+
+/// <summary>
+/// Template function to compute: start + (increment * steps), one step at a time.
+/// Now returns Checked<T> so callers know if an overflow would have occurred.
+/// We prevent overflow by stopping before the unsafe step and setting ok=false.
+/// Cost is O(steps); add_numbers uses it for floating point, where the rounding of
+/// each step matters.
+/// </summary>
+template <typename T>
+Checked<T> add_numbers_loop(T const& start, T const& increment, unsigned long int const& steps)
+{
+    Checked<T> out{ start, true };
+
+    // Iterate step by step so we can preflight each addition regardless of type.
+    for (unsigned long int i = 0; i < steps; ++i)
+    {
+        // Integral path: use bounds checks
+        if constexpr (std::is_integral_v<T>) {
+            if (will_add_overflow_integral<T>(out.value, increment)) {
+                out.ok = false;            // signal overflow would have happened
+                break;                     // prevent it
+            }
+            out.value = static_cast<T>(out.value + increment);
+        }
+        // Floating path: one addition in T, then check that it stayed finite
+        else if constexpr (std::is_floating_point_v<T>) {
+            T next;
+            if (!checked_add_floating<T>(out.value, increment, next)) {
+                out.ok = false;
+                break;
+            }
+            out.value = next;
+        }
+        else {
+            // For unexpected numeric-like types, do a conservative attempt
+            out.value = static_cast<T>(out.value + increment);
+        }
+    }
+
+    return out;
+}
+
+/// <summary>
+/// Template function to compute: start - (decrement * steps), one step at a time.
+/// Returns Checked<T> to communicate safety. Prevents underflow/overflow.
+/// </summary>
+template <typename T>
+Checked<T> subtract_numbers_loop(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    Checked<T> out{ start, true };
+
+    for (unsigned long int i = 0; i < steps; ++i)
+    {
+        if constexpr (std::is_integral_v<T>) {
+            if (will_sub_overflow_integral<T>(out.value, decrement)) {
+                out.ok = false;            // signal underflow or overflow would occur
+                break;                     // prevent it
+            }
+            out.value = static_cast<T>(out.value - decrement);
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            T next;
+            if (!checked_sub_floating<T>(out.value, decrement, next)) {
+                out.ok = false;
+                break;
+            }
+            out.value = next;
+        }
+        else {
+            out.value = static_cast<T>(out.value - decrement);
+        }
+    }
+
+    return out;
+}
+
+/*
+    Helper: the largest number of times `magnitude` can be applied to `start` before
+    passing `limit`, i.e. (distance from start to limit) / magnitude. The distance is
+    taken in the unsigned type so it never overflows, even for signed types spanning
+    their whole range. magnitude must not be 0.
+*/
+template <typename T>
+inline unsigned long long safe_step_count(T start, T limit, std::make_unsigned_t<T> magnitude) {
+    using U = std::make_unsigned_t<T>;
+    using W = std::common_type_t<U, unsigned int>; // avoid int promotion of small types
+    const W distance = (limit >= start)
+        ? static_cast<W>(static_cast<U>(static_cast<U>(limit) - static_cast<U>(start)))
+        : static_cast<W>(static_cast<U>(static_cast<U>(start) - static_cast<U>(limit)));
+    return static_cast<unsigned long long>(distance / static_cast<W>(magnitude));
+}
+
+/*
+    Helper: start moved `steps` times by `magnitude` (up or down), computed modulo 2^N in
+    the unsigned type. Only called when the true result fits in T.
+*/
+template <typename T>
+inline T apply_steps(T start, std::make_unsigned_t<T> magnitude, unsigned long long steps, bool up) {
+    using U = std::make_unsigned_t<T>;
+    using W = std::common_type_t<U, unsigned int>;
+    const W offset = static_cast<W>(static_cast<W>(static_cast<U>(steps)) * static_cast<W>(magnitude));
+    const U base = static_cast<U>(start);
+    return static_cast<T>(static_cast<U>(up ? base + offset : base - offset));
+}
+
+/// <summary>
+/// O(1) version of add_numbers_loop for integral T, with the same value and ok results.
+/// The largest safe step count k = (max - start) / increment (or (start - min) / -increment)
+/// is computed up front: when steps <= k the answer is start + increment * steps, otherwise
+/// the loop would have stopped after k steps with ok=false.
+/// Where the compiler provides __builtin_mul_overflow/__builtin_add_overflow, the common
+/// no-overflow case is answered by them directly.
+/// </summary>
+template <typename T>
+Checked<T> add_numbers_closed_form(T const& start, T const& increment, unsigned long int const& steps)
+{
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "integral only");
+    using U = std::make_unsigned_t<T>;
+    using Lim = std::numeric_limits<T>;
+
+#if defined(__GNUC__) || defined(__clang__)
+    T product;
+    T sum;
+    if (!__builtin_mul_overflow(increment, steps, &product) && !__builtin_add_overflow(start, product, &sum)) {
+        return Checked<T>{ sum, true };
+    }
+#endif
+
+    if (increment == 0) return Checked<T>{ start, true };
+
+    const bool up = increment > 0;
+    const U magnitude = up ? static_cast<U>(increment) : static_cast<U>(U(0) - static_cast<U>(increment));
+    const unsigned long long k = safe_step_count<T>(start, up ? Lim::max() : Lim::min(), magnitude);
+    const bool ok = static_cast<unsigned long long>(steps) <= k;
+    return Checked<T>{ apply_steps<T>(start, magnitude, ok ? steps : k, up), ok };
+}
+
+/// <summary>
+/// O(1) version of subtract_numbers_loop for integral T, with the same value and ok results.
+/// Subtracting a negative decrement moves toward max (a decrement of min is handled exactly
+/// rather than negated).
+/// </summary>
+template <typename T>
+Checked<T> subtract_numbers_closed_form(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "integral only");
+    using U = std::make_unsigned_t<T>;
+    using Lim = std::numeric_limits<T>;
+
+#if defined(__GNUC__) || defined(__clang__)
+    T product;
+    T difference;
+    if (!__builtin_mul_overflow(decrement, steps, &product) && !__builtin_sub_overflow(start, product, &difference)) {
+        return Checked<T>{ difference, true };
+    }
+#endif
+
+    if (decrement == 0) return Checked<T>{ start, true };
+
+    const bool up = decrement < 0;
+    const U magnitude = up ? static_cast<U>(U(0) - static_cast<U>(decrement)) : static_cast<U>(decrement);
+    const unsigned long long k = safe_step_count<T>(start, up ? Lim::max() : Lim::min(), magnitude);
+    const bool ok = static_cast<unsigned long long>(steps) <= k;
+    return Checked<T>{ apply_steps<T>(start, magnitude, ok ? steps : k, up), ok };
+}
+
+/// <summary>
+/// Template function to compute: start + (increment * steps)
+/// Returns Checked<T> so callers know if an overflow would have occurred; the value is the
+/// last safe value. Integral types use the O(1) closed form, floating point steps the loop.
+/// </summary>
+template <typename T>
+Checked<T> add_numbers(T const& start, T const& increment, unsigned long int const& steps)
+{
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return add_numbers_closed_form<T>(start, increment, steps);
+    }
+    else {
+        return add_numbers_loop<T>(start, increment, steps);
+    }
+}
+
+/// <summary>
+/// Template function to compute: start - (decrement * steps)
+/// Returns Checked<T> to communicate safety. Prevents underflow/overflow.
+/// </summary>
+template <typename T>
+Checked<T> subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
+{
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return subtract_numbers_closed_form<T>(start, decrement, steps);
+    }
+    else {
+        return subtract_numbers_loop<T>(start, decrement, steps);
+    }
+}
+
+/*
+    Batch checked arithmetic over arrays.
+
+    Each element follows the Checked<T> contract of a single add/subtract: when the
+    operation is safe out[i] is the result, otherwise out[i] keeps the last safe value
+    (the left operand) and the element is reported as overflowed. Integral types use a
+    branch-free wrap-and-compare test that compilers turn into SIMD compares and blends;
+    floating point uses the same per-element checks as add_numbers. checked_add_sticky and
+    checked_sum_sticky skip the per-element floating checks and read the FE_OVERFLOW flag
+    once per batch instead.
+*/
+struct BatchOverflow {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    std::size_t first_index{ npos };   // first element that would have overflowed
+    std::size_t count{ 0 };            // how many elements would have overflowed
+    bool ok() const { return count == 0; }
+};
+
+/*
+    Helper: out[i] = a[i] +/- b[i] for integral T, flags[i] = 1 when that would overflow.
+    The arithmetic wraps in the unsigned type; the sign/carry test below detects the wrap.
+*/
+template <typename T, bool Subtract>
+inline void batch_integral(const T* a, const T* b, T* out, unsigned char* flags, std::size_t n) {
+    using U = std::make_unsigned_t<T>;
+    for (std::size_t i = 0; i < n; ++i) {
+        const U ua = static_cast<U>(a[i]);
+        const U ub = static_cast<U>(b[i]);
+        const U ur = static_cast<U>(Subtract ? ua - ub : ua + ub);
+        bool overflow;
+        if constexpr (std::is_signed_v<T>) {
+            const U sign = static_cast<U>(U(1) << (sizeof(U) * 8 - 1));
+            // add: operands share a sign that the result lacks; subtract: operands differ
+            // in sign and the result's sign differs from a's
+            overflow = Subtract ? (((ua ^ ub) & (ua ^ ur) & sign) != 0) : (((ua ^ ur) & (ub ^ ur) & sign) != 0);
+        }
+        else {
+            overflow = Subtract ? (ub > ua) : (ur < ua);
+        }
+        out[i] = overflow ? a[i] : static_cast<T>(ur);
+        flags[i] = static_cast<unsigned char>(overflow);
+    }
+}
+
+/*
+    Helper: shared driver for checked_add/checked_sub. Works in chunks of 64 elements so
+    the per-element flags can be packed into one bitmask word per chunk.
+*/
+template <typename T, bool Subtract>
+BatchOverflow checked_batch(std::span<const T> a, std::span<const T> b, std::span<T> out,
+    std::span<std::uint64_t> overflow_bits) {
+    const std::size_t n = std::min({ a.size(), b.size(), out.size() });
+    BatchOverflow result;
+    unsigned char flags[64];
+
+    for (std::size_t base = 0; base < n; base += 64) {
+        const std::size_t len = std::min<std::size_t>(64, n - base);
+        if constexpr (std::is_integral_v<T>) {
+            batch_integral<T, Subtract>(a.data() + base, b.data() + base, out.data() + base, flags, len);
+        }
+        else {
+            for (std::size_t j = 0; j < len; ++j) {
+                const T x = a[base + j];
+                const T y = b[base + j];
+                T next;
+                const bool overflow = Subtract ? !checked_sub_floating<T>(x, y, next) : !checked_add_floating<T>(x, y, next);
+                out[base + j] = overflow ? x : next;
+                flags[j] = static_cast<unsigned char>(overflow);
+            }
+        }
+
+        std::uint64_t word = 0;
+        for (std::size_t j = 0; j < len; ++j) word |= static_cast<std::uint64_t>(flags[j]) << j;
+        if (base / 64 < overflow_bits.size()) overflow_bits[base / 64] = word;
+        if (word != 0) {
+            if (result.first_index == BatchOverflow::npos) {
+                std::size_t j = 0;
+                while (((word >> j) & 1u) == 0) ++j;
+                result.first_index = base + j;
+            }
+            for (std::uint64_t w = word; w != 0; w &= w - 1) ++result.count;
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// out[i] = a[i] + b[i] for every i, checked per element like add_numbers.
+/// overflow_bits (optional, one word per 64 elements) receives bit i%64 of word i/64 for
+/// each element that would have overflowed; those elements keep a[i].
+/// </summary>
+template <typename T>
+BatchOverflow checked_add(std::span<const T> a, std::span<const T> b, std::span<T> out,
+    std::span<std::uint64_t> overflow_bits = {}) {
+    return checked_batch<T, false>(a, b, out, overflow_bits);
+}
+
+/// <summary>
+/// out[i] = a[i] - b[i] for every i, checked per element like subtract_numbers.
+/// </summary>
+template <typename T>
+BatchOverflow checked_sub(std::span<const T> a, std::span<const T> b, std::span<T> out,
+    std::span<std::uint64_t> overflow_bits = {}) {
+    return checked_batch<T, true>(a, b, out, overflow_bits);
+}
+
+// Result of a checked reduction: Checked<T> plus where it stopped.
+template <typename T>
+struct CheckedSum : Checked<T> {
+    std::size_t failed_index{ BatchOverflow::npos };  // element that would have overflowed
+};
+
+/// <summary>
+/// start + values[0] + values[1] + ..., added in order with the Checked<T> contract:
+/// the sum stops before the first element that would overflow, value is the last safe
+/// sum and failed_index names that element.
+/// Integral types are summed in blocks: the positive and negative parts of a block are
+/// accumulated in 64-bit lanes, and when the running total plus either part stays in
+/// range no prefix of the block can overflow, so the block is taken whole. Only a block
+/// that might overflow is re-added one element at a time.
+/// </summary>
+template <typename T>
+CheckedSum<T> checked_sum(std::span<const T> values, T start = T(0)) {
+    CheckedSum<T> out;
+    out.value = start;
+    out.ok = true;
+
+    if constexpr (std::is_integral_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        using Lim = std::numeric_limits<T>;
+        constexpr std::size_t block = 256;
+
+        for (std::size_t base = 0; base < values.size(); base += block) {
+            const std::size_t len = std::min(block, values.size() - base);
+            const T* v = values.data() + base;
+
+            std::uint64_t up = 0;      // sum of positive elements
+            std::uint64_t down = 0;    // sum of magnitudes of negative elements
+            std::uint64_t carry = 0;   // non-zero if either sum wrapped (only possible for 64-bit T)
+            for (std::size_t j = 0; j < len; ++j) {
+                // sign-extend, then split into the positive part and the negative magnitude
+                const std::uint64_t x = std::is_signed_v<T>
+                    ? static_cast<std::uint64_t>(static_cast<long long>(v[j]))
+                    : static_cast<std::uint64_t>(v[j]);
+                const std::uint64_t negative = (std::is_signed_v<T> && (x >> 63) != 0) ? ~std::uint64_t(0) : 0;
+                const std::uint64_t add_up = x & ~negative;
+                const std::uint64_t add_down = (std::uint64_t(0) - x) & negative;
+                up += add_up;
+                down += add_down;
+                if constexpr (sizeof(T) >= sizeof(std::uint64_t)) {
+                    carry |= static_cast<std::uint64_t>(up < add_up) | static_cast<std::uint64_t>(down < add_down);
+                }
+            }
+
+            const std::uint64_t headroom_up = static_cast<U>(static_cast<U>(Lim::max()) - static_cast<U>(out.value));
+            const std::uint64_t headroom_down = static_cast<U>(static_cast<U>(out.value) - static_cast<U>(Lim::min()));
+            if (carry == 0 && up <= headroom_up && down <= headroom_down) {
+                out.value = static_cast<T>(static_cast<U>(static_cast<U>(out.value) + static_cast<U>(up) - static_cast<U>(down)));
+                continue;
+            }
+
+            for (std::size_t j = 0; j < len; ++j) {
+                if (will_add_overflow_integral<T>(out.value, v[j])) {
+                    out.ok = false;
+                    out.failed_index = base + j;
+                    return out;
+                }
+                out.value = static_cast<T>(out.value + v[j]);
+            }
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            T next;
+            if (!checked_add_floating<T>(out.value, values[i], next)) {
+                out.ok = false;
+                out.failed_index = i;
+                return out;
+            }
+            out.value = next;
+        }
+    }
+    return out;
+}
+
+/*
+    Helper: reads the sticky floating point exception flags once for a whole batch.
+    Construction clears FE_OVERFLOW and FE_UNDERFLOW; after plain arithmetic, overflowed()
+    tells whether any operation since then rounded to infinity, underflowed() whether any
+    result lost precision below the smallest normal value.
+*/
+class FloatingExceptionScope {
+public:
+    FloatingExceptionScope() { std::feclearexcept(FE_OVERFLOW | FE_UNDERFLOW); }
+    bool overflowed() const { return std::fetestexcept(FE_OVERFLOW) != 0; }
+    bool underflowed() const { return std::fetestexcept(FE_UNDERFLOW) != 0; }
+};
+
+/// <summary>
+/// checked_add for floating point that adds the whole batch unchecked and then tests the
+/// sticky FE_OVERFLOW flag once. Only when it is set is the batch redone element by element
+/// (via checked_add) to find which results overflowed. The inputs must be finite (adding
+/// to an infinity does not raise FE_OVERFLOW), and out must not alias a or b.
+/// </summary>
+template <typename T>
+BatchOverflow checked_add_sticky(std::span<const T> a, std::span<const T> b, std::span<T> out,
+    std::span<std::uint64_t> overflow_bits = {}) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    const std::size_t n = std::min({ a.size(), b.size(), out.size() });
+    {
+        FloatingExceptionScope flags;
+        for (std::size_t i = 0; i < n; ++i) out[i] = static_cast<T>(a[i] + b[i]);
+        if (!flags.overflowed()) {
+            for (auto& word : overflow_bits) word = 0;
+            return BatchOverflow{};
+        }
+    }
+    return checked_add<T>(a, b, out, overflow_bits);
+}
+
+/// <summary>
+/// checked_sum for floating point with one FE_OVERFLOW test per batch; on overflow the
+/// sum is redone with checked_sum to find the failing element. Inputs must be finite.
+/// </summary>
+template <typename T>
+CheckedSum<T> checked_sum_sticky(std::span<const T> values, T start = T(0)) {
+    static_assert(std::is_floating_point_v<T>, "floating only");
+    {
+        FloatingExceptionScope flags;
+        T sum = start;
+        for (const T value : values) sum = static_cast<T>(sum + value);
+        if (!flags.overflowed()) {
+            CheckedSum<T> out;
+            out.value = sum;
+            out.ok = true;
+            return out;
+        }
+    }
+    return checked_sum<T>(values, start);
+}
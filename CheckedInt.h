@@ -0,0 +1,271 @@
+// CheckedInt.h : Header-only, constexpr checked integer arithmetic with a type-level policy.
+//
+// checked_int<T, Policy> wraps an integral T. Every +, - and * is checked for
+// overflow, and the policy (chosen at compile time, so no runtime dispatch remains)
+// decides what an overflowing operation produces:
+//   checked::trap      throws std::overflow_error; in a constant expression that is a
+//                      compile error, so range checks on constants fail the build
+//   checked::saturate  clamps to numeric_limits<T>::max() / min()
+//   checked::wrap      two's complement wrap-around, no check at all
+//   checked::report    keeps the last safe value and clears a sticky ok() flag,
+//                      the same contract as Checked<T> in the numeric overflow module
+// Everything is constexpr, so checks on constants and fixed loop bounds are
+// evaluated by the compiler and leave no code behind.
+//
+
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace checked
+{
+    struct trap
+    {
+        static constexpr bool reports = false;
+        static constexpr bool checks = true;
+
+        template <typename T>
+        static constexpr T on_overflow(T /*last_safe*/, T /*wrapped*/, bool /*upward*/)
+        {
+            throw std::overflow_error("checked_int overflow");
+        }
+    };
+
+    struct saturate
+    {
+        static constexpr bool reports = false;
+        static constexpr bool checks = true;
+
+        template <typename T>
+        static constexpr T on_overflow(T /*last_safe*/, T /*wrapped*/, bool upward)
+        {
+            return upward ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+        }
+    };
+
+    struct wrap
+    {
+        static constexpr bool reports = false;
+        static constexpr bool checks = false;
+
+        template <typename T>
+        static constexpr T on_overflow(T /*last_safe*/, T wrapped, bool /*upward*/)
+        {
+            return wrapped;
+        }
+    };
+
+    struct report
+    {
+        static constexpr bool reports = true;
+        static constexpr bool checks = true;
+
+        template <typename T>
+        static constexpr T on_overflow(T last_safe, T /*wrapped*/, bool /*upward*/)
+        {
+            return last_safe;
+        }
+    };
+
+    namespace detail
+    {
+        // Arithmetic in the unsigned type of at least int width: never undefined, and
+        // small types are not promoted to (signed) int.
+        template <typename T>
+        using wide_unsigned = std::common_type_t<std::make_unsigned_t<T>, unsigned int>;
+
+        template <typename T>
+        constexpr T wrapped_add(T a, T b)
+        {
+            using U = std::make_unsigned_t<T>;
+            using W = wide_unsigned<T>;
+            return static_cast<T>(static_cast<U>(static_cast<W>(static_cast<U>(a)) + static_cast<W>(static_cast<U>(b))));
+        }
+
+        template <typename T>
+        constexpr T wrapped_sub(T a, T b)
+        {
+            using U = std::make_unsigned_t<T>;
+            using W = wide_unsigned<T>;
+            return static_cast<T>(static_cast<U>(static_cast<W>(static_cast<U>(a)) - static_cast<W>(static_cast<U>(b))));
+        }
+
+        template <typename T>
+        constexpr T wrapped_mul(T a, T b)
+        {
+            using U = std::make_unsigned_t<T>;
+            using W = wide_unsigned<T>;
+            return static_cast<T>(static_cast<U>(static_cast<W>(static_cast<U>(a)) * static_cast<W>(static_cast<U>(b))));
+        }
+
+        template <typename T>
+        constexpr bool add_overflows(T a, T b)
+        {
+            using Lim = std::numeric_limits<T>;
+            if constexpr (std::is_signed_v<T>)
+                return (b > 0 && a > Lim::max() - b) || (b < 0 && a < Lim::min() - b);
+            else
+                return a > Lim::max() - b;
+        }
+
+        template <typename T>
+        constexpr bool sub_overflows(T a, T b)
+        {
+            using Lim = std::numeric_limits<T>;
+            if constexpr (std::is_signed_v<T>)
+                return (b < 0 && a > Lim::max() + b) || (b > 0 && a < Lim::min() + b);
+            else
+                return b > a;
+        }
+
+        template <typename T>
+        constexpr bool mul_overflows(T a, T b)
+        {
+            using Lim = std::numeric_limits<T>;
+            if (a == 0 || b == 0) return false;
+            if constexpr (std::is_signed_v<T>)
+            {
+                if (a > 0)
+                    return b > 0 ? a > Lim::max() / b : b < Lim::min() / a;
+                return b > 0 ? a < Lim::min() / b : a < Lim::max() / b;
+            }
+            else
+            {
+                return a > Lim::max() / b;
+            }
+        }
+
+        struct no_flag
+        {
+            constexpr bool get() const { return true; }
+            constexpr void clear() {}
+        };
+
+        struct sticky_flag
+        {
+            bool ok = true;
+            constexpr bool get() const { return ok; }
+            constexpr void clear() { ok = false; }
+        };
+    }
+
+    template <typename T, typename Policy = report>
+    class checked_int
+    {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "checked_int needs an integral type");
+
+    public:
+        using value_type = T;
+        using policy_type = Policy;
+
+        constexpr checked_int() = default;
+        constexpr checked_int(T value) : value_(value) {}
+
+        constexpr T value() const { return value_; }
+
+        // False once an operation overflowed (report policy only; always true otherwise).
+        constexpr bool ok() const { return flag_.get(); }
+
+        constexpr checked_int& operator+=(T rhs)
+        {
+            if constexpr (Policy::checks)
+            {
+                if (detail::add_overflows(value_, rhs))
+                    return overflowed(detail::wrapped_add(value_, rhs), rhs > 0);
+            }
+            value_ = detail::wrapped_add(value_, rhs);
+            return *this;
+        }
+
+        constexpr checked_int& operator-=(T rhs)
+        {
+            if constexpr (Policy::checks)
+            {
+                if (detail::sub_overflows(value_, rhs))
+                    return overflowed(detail::wrapped_sub(value_, rhs), rhs < 0);
+            }
+            value_ = detail::wrapped_sub(value_, rhs);
+            return *this;
+        }
+
+        constexpr checked_int& operator*=(T rhs)
+        {
+            if constexpr (Policy::checks)
+            {
+                if (detail::mul_overflows(value_, rhs))
+                {
+                    const bool upward = std::is_signed_v<T> ? ((value_ < 0) == (rhs < 0)) : true;
+                    return overflowed(detail::wrapped_mul(value_, rhs), upward);
+                }
+            }
+            value_ = detail::wrapped_mul(value_, rhs);
+            return *this;
+        }
+
+        constexpr checked_int& operator+=(checked_int rhs) { merge(rhs); return *this += rhs.value_; }
+        constexpr checked_int& operator-=(checked_int rhs) { merge(rhs); return *this -= rhs.value_; }
+        constexpr checked_int& operator*=(checked_int rhs) { merge(rhs); return *this *= rhs.value_; }
+
+        friend constexpr checked_int operator+(checked_int lhs, checked_int rhs) { return lhs += rhs; }
+        friend constexpr checked_int operator-(checked_int lhs, checked_int rhs) { return lhs -= rhs; }
+        friend constexpr checked_int operator*(checked_int lhs, checked_int rhs) { return lhs *= rhs; }
+
+        friend constexpr bool operator==(checked_int lhs, checked_int rhs) { return lhs.value_ == rhs.value_; }
+        friend constexpr bool operator!=(checked_int lhs, checked_int rhs) { return lhs.value_ != rhs.value_; }
+        friend constexpr bool operator<(checked_int lhs, checked_int rhs) { return lhs.value_ < rhs.value_; }
+        friend constexpr bool operator>(checked_int lhs, checked_int rhs) { return lhs.value_ > rhs.value_; }
+        friend constexpr bool operator<=(checked_int lhs, checked_int rhs) { return lhs.value_ <= rhs.value_; }
+        friend constexpr bool operator>=(checked_int lhs, checked_int rhs) { return lhs.value_ >= rhs.value_; }
+
+    private:
+        constexpr checked_int& overflowed(T wrapped, bool upward)
+        {
+            value_ = Policy::template on_overflow<T>(value_, wrapped, upward);
+            if constexpr (Policy::reports) flag_.clear();
+            return *this;
+        }
+
+        // an operand that already overflowed makes the result not ok
+        constexpr void merge(checked_int rhs)
+        {
+            if constexpr (Policy::reports)
+            {
+                if (!rhs.ok()) flag_.clear();
+            }
+        }
+
+        using flag_type = std::conditional_t<Policy::reports, detail::sticky_flag, detail::no_flag>;
+
+        T value_{};
+        [[no_unique_address]] flag_type flag_{};
+    };
+
+    // constexpr mirror of add_numbers: start + increment, `steps` times, stopping at the
+    // first overflow under the report policy (trap throws, saturate/wrap keep going).
+    template <typename T, typename Policy = report>
+    constexpr checked_int<T, Policy> add_steps(T start, T increment, unsigned long steps)
+    {
+        checked_int<T, Policy> out(start);
+        for (unsigned long i = 0; i < steps; ++i)
+        {
+            out += increment;
+            if (!out.ok()) break;
+        }
+        return out;
+    }
+
+    // constexpr mirror of subtract_numbers.
+    template <typename T, typename Policy = report>
+    constexpr checked_int<T, Policy> subtract_steps(T start, T decrement, unsigned long steps)
+    {
+        checked_int<T, Policy> out(start);
+        for (unsigned long i = 0; i < steps; ++i)
+        {
+            out -= decrement;
+            if (!out.ok()) break;
+        }
+        return out;
+    }
+}
@@ -0,0 +1,491 @@
+// CredentialStore.h : Memory-mapped store of salted password hashes for Project One.
+//
+// The store is built once (build_credential_file) into a file that is already the lookup
+// structure: a header followed by an open-addressing hash table of fixed-size slots keyed
+// by username, with linear probing and a load factor of at most 1/2. Opening the store
+// maps the file read-only and checks the header; nothing is parsed, so start-up time does
+// not grow with the number of accounts, and a lookup touches one or two slots.
+//
+// Each slot holds a 16-byte random salt, its PBKDF2 iteration count and the
+// PBKDF2-HMAC-SHA256 (RFC 8018) key derived from the password; the stored and computed keys
+// are compared in constant time. Unknown usernames run the same derivation with the
+// store's default count, so a failed login takes as long whether or not the account
+// exists. The build writes the file readable by its owner only (0600). The file uses the
+// host's byte order.
+//
+// Project One reads operators.cred from its working directory. Build it from a text file
+// of "username password" lines (no whitespace inside a password):
+//   project_one --build-credentials accounts.txt operators.cred
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace credential_detail
+{
+    // Plain SHA-256 (FIPS 180-4).
+    class Sha256
+    {
+    public:
+        static constexpr std::size_t digest_size = 32;
+        using Digest = std::array<std::uint8_t, digest_size>;
+
+        Sha256() { reset(); }
+
+        void reset()
+        {
+            static constexpr std::uint32_t initial[8] = {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+            std::memcpy(state_, initial, sizeof(state_));
+            length_ = 0;
+            used_ = 0;
+        }
+
+        void update(const void* data, std::size_t size)
+        {
+            const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+            length_ += size;
+            while (size > 0)
+            {
+                const std::size_t take = std::min(size, sizeof(block_) - used_);
+                std::memcpy(block_ + used_, p, take);
+                used_ += take;
+                p += take;
+                size -= take;
+                if (used_ == sizeof(block_))
+                {
+                    compress(block_);
+                    used_ = 0;
+                }
+            }
+        }
+
+        Digest finish()
+        {
+            const std::uint64_t bits = length_ * 8;
+            const std::uint8_t pad = 0x80;
+            update(&pad, 1);
+            const std::uint8_t zero = 0;
+            while (used_ != 56) update(&zero, 1);
+            std::uint8_t tail[8];
+            for (int i = 0; i < 8; ++i) tail[i] = static_cast<std::uint8_t>(bits >> (56 - 8 * i));
+            update(tail, 8);
+
+            Digest out;
+            for (int i = 0; i < 8; ++i)
+            {
+                for (int j = 0; j < 4; ++j) out[static_cast<std::size_t>(4 * i + j)] = static_cast<std::uint8_t>(state_[i] >> (24 - 8 * j));
+            }
+            reset();
+            return out;
+        }
+
+    private:
+        static std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        void compress(const std::uint8_t* block)
+        {
+            static constexpr std::uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+
+            std::uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+            {
+                w[i] = (static_cast<std::uint32_t>(block[4 * i]) << 24) | (static_cast<std::uint32_t>(block[4 * i + 1]) << 16)
+                    | (static_cast<std::uint32_t>(block[4 * i + 2]) << 8) | static_cast<std::uint32_t>(block[4 * i + 3]);
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                const std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                const std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            std::uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+            std::uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                const std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                const std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+            state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+            state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+        }
+
+        std::uint32_t state_[8];
+        std::uint64_t length_;
+        std::uint8_t block_[64];
+        std::size_t used_;
+    };
+
+    // PBKDF2-HMAC-SHA256 with a 32-byte output: one block, so the key is T1 = U1 ^ ... ^ Uc.
+    inline Sha256::Digest pbkdf2_sha256(std::string_view password, const std::uint8_t* salt, std::size_t salt_length,
+        std::uint32_t iterations)
+    {
+        std::uint8_t key[64] = {};
+        if (password.size() > sizeof(key))
+        {
+            Sha256 sha;
+            sha.update(password.data(), password.size());
+            const Sha256::Digest digest = sha.finish();
+            std::memcpy(key, digest.data(), digest.size());
+        }
+        else
+        {
+            std::memcpy(key, password.data(), password.size());
+        }
+
+        // the HMAC pads are hashed once; every round resumes from copies of the two states
+        std::uint8_t pad[64];
+        Sha256 inner, outer;
+        for (std::size_t i = 0; i < sizeof(pad); ++i) pad[i] = static_cast<std::uint8_t>(key[i] ^ 0x36);
+        inner.update(pad, sizeof(pad));
+        for (std::size_t i = 0; i < sizeof(pad); ++i) pad[i] = static_cast<std::uint8_t>(key[i] ^ 0x5c);
+        outer.update(pad, sizeof(pad));
+
+        auto hmac = [&](const void* first, std::size_t first_size, const void* second, std::size_t second_size) {
+            Sha256 h = inner;
+            h.update(first, first_size);
+            h.update(second, second_size);
+            const Sha256::Digest inner_digest = h.finish();
+            h = outer;
+            h.update(inner_digest.data(), inner_digest.size());
+            return h.finish();
+        };
+
+        static const std::uint8_t block_index[4] = { 0, 0, 0, 1 };
+        Sha256::Digest u = hmac(salt, salt_length, block_index, sizeof(block_index));
+        Sha256::Digest t = u;
+        for (std::uint32_t i = 1; i < iterations; ++i)
+        {
+            u = hmac(u.data(), u.size(), NULL, 0);
+            for (std::size_t b = 0; b < t.size(); ++b) t[b] = static_cast<std::uint8_t>(t[b] ^ u[b]);
+        }
+        return t;
+    }
+
+    constexpr std::size_t salt_size = 16;
+    constexpr std::size_t max_username = 63;
+
+    // PBKDF2 rounds for new records: OWASP's 2023 figure for PBKDF2-HMAC-SHA256.
+    constexpr std::uint32_t default_iterations = 600000;
+
+    // On-disk layout; both structs are read in place from the mapping.
+    struct Header
+    {
+        char magic[8];                 // "P1CREDS\0"
+        std::uint32_t version;
+        std::uint32_t iterations;      // PBKDF2 rounds for unknown usernames (the build's default)
+        std::uint64_t slot_count;      // a power of two
+        std::uint64_t record_count;
+        std::uint8_t reserved[32];
+    };
+
+    struct Slot
+    {
+        std::uint64_t key;             // key_hash(username); 0 marks an empty slot
+        std::uint8_t name_length;
+        char name[max_username];
+        std::uint8_t salt[salt_size];
+        std::uint8_t digest[Sha256::digest_size];
+        std::uint32_t iterations;      // PBKDF2 rounds of this record
+        std::uint8_t reserved[4];
+    };
+
+    static_assert(sizeof(Header) == 64, "credential header layout");
+    static_assert(sizeof(Slot) == 128, "credential slot layout");
+
+    constexpr char magic[8] = { 'P', '1', 'C', 'R', 'E', 'D', 'S', '\0' };
+    constexpr std::uint32_t version = 2;   // 1 was an iterated plain SHA-256
+
+    // FNV-1a, never 0 (0 marks empty slots).
+    inline std::uint64_t key_hash(std::string_view username)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (const unsigned char c : username)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h != 0 ? h : 1;
+    }
+
+    inline Sha256::Digest password_digest(const std::uint8_t* salt, std::string_view password, std::uint32_t iterations)
+    {
+        return pbkdf2_sha256(password, salt, salt_size, iterations);
+    }
+
+    // Compares all n bytes regardless of where they first differ.
+    inline bool equal_constant_time(const std::uint8_t* a, const std::uint8_t* b, std::size_t n)
+    {
+        std::uint8_t diff = 0;
+        for (std::size_t i = 0; i < n; ++i) diff = static_cast<std::uint8_t>(diff | (a[i] ^ b[i]));
+        return diff == 0;
+    }
+}
+
+struct Credential
+{
+    std::string username;
+    std::string password;
+};
+
+// Writes a store for the given accounts to path, readable by its owner only. Usernames must
+// be unique, non-empty and at most 63 bytes. iterations sets the PBKDF2 cost of each
+// password; it is stored with every record, so a later build may raise it.
+inline bool build_credential_file(const std::string& path, const std::vector<Credential>& accounts,
+    std::string* error = NULL, std::uint32_t iterations = credential_detail::default_iterations)
+{
+    using namespace credential_detail;
+
+    std::uint64_t slot_count = 16;
+    while (slot_count < 2 * static_cast<std::uint64_t>(accounts.size())) slot_count *= 2;
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.iterations = iterations != 0 ? iterations : 1;
+    header.slot_count = slot_count;
+    header.record_count = accounts.size();
+
+    std::vector<Slot> slots(static_cast<std::size_t>(slot_count));
+    std::memset(slots.data(), 0, slots.size() * sizeof(Slot));
+    std::random_device random;
+
+    for (const Credential& account : accounts)
+    {
+        if (account.username.empty() || account.username.size() > max_username)
+        {
+            if (error) *error = "username must be 1 to 63 bytes: " + account.username;
+            return false;
+        }
+        const std::uint64_t key = key_hash(account.username);
+        std::size_t i = static_cast<std::size_t>(key & (slot_count - 1));
+        while (slots[i].key != 0)
+        {
+            if (slots[i].key == key && std::string_view(slots[i].name, slots[i].name_length) == account.username)
+            {
+                if (error) *error = "duplicate username: " + account.username;
+                return false;
+            }
+            i = (i + 1) & static_cast<std::size_t>(slot_count - 1);
+        }
+
+        Slot& slot = slots[i];
+        slot.key = key;
+        slot.name_length = static_cast<std::uint8_t>(account.username.size());
+        std::memcpy(slot.name, account.username.data(), account.username.size());
+        for (std::size_t b = 0; b < salt_size; b += 4)
+        {
+            const std::uint32_t r = random();
+            std::memcpy(slot.salt + b, &r, 4);
+        }
+        slot.iterations = header.iterations;
+        const Sha256::Digest digest = password_digest(slot.salt, account.password, slot.iterations);
+        std::memcpy(slot.digest, digest.data(), digest.size());
+    }
+
+#if defined(_WIN32)
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(Slot)));
+    if (!out)
+    {
+        if (error) *error = "could not write " + path;
+        return false;
+    }
+#else
+    // 0600 from the start, and again for a file that already existed with wider permissions
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0 || ::fchmod(fd, S_IRUSR | S_IWUSR) != 0)
+    {
+        if (fd >= 0) ::close(fd);
+        if (error) *error = "could not create " + path;
+        return false;
+    }
+    bool ok = true;
+    auto write_all = [&](const void* data, std::size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (ok && size > 0)
+        {
+            const ssize_t n = ::write(fd, p, size);
+            if (n <= 0) { ok = false; break; }
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+    };
+    write_all(&header, sizeof(header));
+    write_all(slots.data(), slots.size() * sizeof(Slot));
+    ok = ::close(fd) == 0 && ok;
+    if (!ok)
+    {
+        if (error) *error = "could not write " + path;
+        return false;
+    }
+#endif
+    return true;
+}
+
+class CredentialStore
+{
+public:
+    CredentialStore() = default;
+    ~CredentialStore() { close(); }
+
+    CredentialStore(const CredentialStore&) = delete;
+    CredentialStore& operator=(const CredentialStore&) = delete;
+
+    // Maps the store at path. On failure the store stays closed and verify() rejects everyone.
+    bool open(const std::string& path, std::string* error = NULL)
+    {
+        using namespace credential_detail;
+        close();
+
+#if defined(_WIN32)
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            if (error) *error = "could not open " + path;
+            return false;
+        }
+        copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = copy_.data();
+        size_ = copy_.size();
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            if (error) *error = "could not open " + path;
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header)))
+        {
+            ::close(fd);
+            if (error) *error = path + " is not a credential store";
+            return false;
+        }
+        void* mapped = ::mmap(NULL, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            if (error) *error = "could not map " + path;
+            return false;
+        }
+        data_ = static_cast<const char*>(mapped);
+        size_ = static_cast<std::size_t>(info.st_size);
+        mapped_ = true;
+#endif
+
+        const Header* header = size_ >= sizeof(Header) ? reinterpret_cast<const Header*>(data_) : NULL;
+        if (header != NULL && std::memcmp(header->magic, magic, sizeof(magic)) == 0 && header->version < version)
+        {
+            close();
+            if (error) *error = path + " uses an older password hash; rebuild it with --build-credentials";
+            return false;
+        }
+        if (header == NULL || std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version
+            || header->iterations == 0 || header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0
+            || header->slot_count > (size_ - sizeof(Header)) / sizeof(Slot)
+            || size_ != sizeof(Header) + header->slot_count * sizeof(Slot))
+        {
+            close();
+            if (error) *error = path + " is not a credential store";
+            return false;
+        }
+        header_ = header;
+        slots_ = reinterpret_cast<const Slot*>(data_ + sizeof(Header));
+        return true;
+    }
+
+    void close()
+    {
+#if !defined(_WIN32)
+        if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#else
+        copy_.clear();
+#endif
+        mapped_ = false;
+        data_ = NULL;
+        size_ = 0;
+        header_ = NULL;
+        slots_ = NULL;
+    }
+
+    bool is_open() const { return header_ != NULL; }
+    std::size_t size() const { return header_ != NULL ? static_cast<std::size_t>(header_->record_count) : 0; }
+
+    // True when username exists and password matches. Safe to call from many threads.
+    bool verify(std::string_view username, std::string_view password) const
+    {
+        using namespace credential_detail;
+        static const std::uint8_t no_salt[salt_size] = {};
+        static const std::uint8_t no_digest[Sha256::digest_size] = {};
+
+        const Slot* slot = find(username);
+        const std::uint32_t iterations = slot != NULL && slot->iterations != 0 ? slot->iterations
+            : (header_ != NULL ? header_->iterations : default_iterations);
+        // unknown users pay for the same hash and compare as known ones
+        const Sha256::Digest digest = password_digest(slot != NULL ? slot->salt : no_salt, password, iterations);
+        const bool match = equal_constant_time(digest.data(), slot != NULL ? slot->digest : no_digest, digest.size());
+        return slot != NULL && match;
+    }
+
+private:
+    const credential_detail::Slot* find(std::string_view username) const
+    {
+        using namespace credential_detail;
+        if (header_ == NULL || username.empty() || username.size() > max_username) return NULL;
+
+        const std::uint64_t key = key_hash(username);
+        const std::uint64_t mask = header_->slot_count - 1;
+        for (std::uint64_t probe = 0, i = key & mask; probe <= mask; ++probe, i = (i + 1) & mask)
+        {
+            const Slot& slot = slots_[i];
+            if (slot.key == 0) return NULL;
+            if (slot.key == key && slot.name_length == username.size()
+                && std::memcmp(slot.name, username.data(), username.size()) == 0)
+            {
+                return &slot;
+            }
+        }
+        return NULL;
+    }
+
+    const char* data_ = NULL;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+#if defined(_WIN32)
+    std::vector<char> copy_;
+#endif
+    const credential_detail::Header* header_ = NULL;
+    const credential_detail::Slot* slots_ = NULL;
+};
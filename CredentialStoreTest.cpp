@@ -0,0 +1,84 @@
+// CredentialStoreTest.cpp : Checks of the PBKDF2 derivation and the credential store.
+//
+// The derivation is checked against the PBKDF2-HMAC-SHA256 vectors of RFC 7914 section 11,
+// then a small store is built, reopened and queried: right and wrong passwords, unknown
+// users, and the owner-only permissions of the file. Exits non-zero on the first failure.
+// Run by ctest (test credential_store).
+//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CredentialStore.h"
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++failures;
+        }
+    }
+
+    std::string hex(const credential_detail::Sha256::Digest& digest)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string text;
+        for (const std::uint8_t b : digest)
+        {
+            text += digits[b >> 4];
+            text += digits[b & 15];
+        }
+        return text;
+    }
+
+    std::string pbkdf2(const char* password, const char* salt, std::uint32_t iterations)
+    {
+        return hex(credential_detail::pbkdf2_sha256(password, reinterpret_cast<const std::uint8_t*>(salt), std::strlen(salt), iterations));
+    }
+}
+
+int main()
+{
+    // RFC 7914, the first 32 bytes of each derived key
+    expect(pbkdf2("passwd", "salt", 1) == "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc",
+        "PBKDF2-HMAC-SHA256 passwd/salt/1");
+    expect(pbkdf2("Password", "NaCl", 80000) == "4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56",
+        "PBKDF2-HMAC-SHA256 Password/NaCl/80000");
+
+    const std::string path = "credential_store_test.cred";
+    const std::vector<Credential> accounts = { { "admin", "s3cret" }, { "operator", "hunter2" } };
+    std::string error;
+    expect(build_credential_file(path, accounts, &error, 1000), "build_credential_file");
+
+    CredentialStore store;
+    expect(store.open(path, &error), "open the built store");
+    expect(store.size() == 2, "two accounts");
+    expect(store.verify("admin", "s3cret"), "right password");
+    expect(store.verify("operator", "hunter2"), "second account");
+    expect(!store.verify("admin", "hunter2"), "another account's password");
+    expect(!store.verify("admin", "s3cret "), "password with a trailing space");
+    expect(!store.verify("nobody", "s3cret"), "unknown user");
+    expect(!store.verify("", ""), "empty username");
+
+#if !defined(_WIN32)
+    struct stat info;
+    expect(::stat(path.c_str(), &info) == 0 && (info.st_mode & 0777) == 0600, "store is 0600");
+#endif
+
+    std::vector<Credential> duplicate = accounts;
+    duplicate.push_back(Credential{ "admin", "again" });
+    expect(!build_credential_file(path + ".dup", duplicate, &error, 1), "duplicate usernames are refused");
+
+    store.close();
+    std::remove(path.c_str());
+    std::remove((path + ".dup").c_str());
+    std::printf("%s\n", failures == 0 ? "all credential store checks passed" : "credential store checks failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,470 @@
+// CustomerStore.h : In-memory customer records with a hash index and an append-only log.
+//
+// Records are fixed-size structs (no heap strings) kept contiguously in one vector; an
+// open-addressing index maps customer IDs to vector positions, storing a 32-bit hash tag
+// next to each position so a probe only touches the record it is about to return.
+//
+// Every change is appended to a log file as a small checksummed record. Appends collect in
+// a buffer and are written (and synced with fsync) together - group commit - once the
+// buffer reaches commit_bytes, when a change finds the oldest pending one commit_interval
+// old, or on commit(). A change is durable once the commit that wrote it returns. Opening
+// the store reads the log in one pass and replays it; a record torn by a crash is cut off
+// the end. A store whose log could not be opened still takes changes, in memory only: they
+// apply as usual, commit() reports false, and they are gone when the process exits.
+//
+// Sessions on several threads may share one store: get() copies a record under a shared
+// lock, changes take the lock exclusively while they update memory and queue their log
+// record, and commit() writes and syncs outside that lock, so one session's fsync never
+// stalls another session's reads or changes. Changes queued during a sync go out together
+// in the next commit. open(), close() and find() are for single-threaded use.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+struct Customer
+{
+    char id[16];
+    char name[32];
+    char company[32];
+    char service_plan[16];
+    char billing_address[64];
+    char contact[32];
+    std::int32_t tier;          // index into customer_tier_names
+
+    std::string_view get_id() const { return field(id); }
+    std::string_view get_name() const { return field(name); }
+    std::string_view get_company() const { return field(company); }
+    std::string_view get_service_plan() const { return field(service_plan); }
+    std::string_view get_billing_address() const { return field(billing_address); }
+    std::string_view get_contact() const { return field(contact); }
+
+    // Stores value, cut to the field's size; returns false if it had to be cut.
+    template <std::size_t N>
+    static bool set(char (&to)[N], std::string_view value)
+    {
+        const std::size_t n = std::min(value.size(), N);
+        std::memcpy(to, value.data(), n);
+        std::memset(to + n, 0, N - n);
+        return n == value.size();
+    }
+
+private:
+    template <std::size_t N>
+    static std::string_view field(const char (&from)[N])
+    {
+        const void* end = std::memchr(from, '\0', N);
+        return std::string_view(from, end != nullptr ? static_cast<const char*>(end) - from : N);
+    }
+};
+
+static_assert(sizeof(Customer) == 196, "Customer layout");
+
+constexpr const char* customer_tier_names[] = { "Basic", "Standard", "Premium", "Enterprise" };
+constexpr std::int32_t customer_tier_count = 4;
+
+class CustomerStore
+{
+public:
+    struct Options
+    {
+        std::size_t commit_bytes = 64 * 1024;
+        std::chrono::milliseconds commit_interval{ 5 };
+        bool sync = true;       // fsync at every commit
+    };
+
+    CustomerStore() = default;
+    explicit CustomerStore(Options options) : options_(options) {}
+
+    ~CustomerStore()
+    {
+        close();
+    }
+
+    CustomerStore(const CustomerStore&) = delete;
+    CustomerStore& operator=(const CustomerStore&) = delete;
+
+    // Replays the log at path (created if missing) and keeps it open for appends.
+    bool open(const std::string& path, std::string* error = NULL)
+    {
+        close();
+        records_.clear();
+        index_.assign(16, Slot{});
+        replayed_ = 0;
+
+        std::string data;
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (in)
+            {
+                in.seekg(0, std::ios::end);
+                data.resize(static_cast<std::size_t>(in.tellg()));
+                in.seekg(0);
+                in.read(&data[0], static_cast<std::streamsize>(data.size()));
+            }
+        }
+
+        std::size_t offset = 0;
+        while (offset < data.size())
+        {
+            const std::size_t used = apply_record(data.data() + offset, data.size() - offset);
+            if (used == 0) break;
+            offset += used;
+            ++replayed_;
+        }
+        if (offset < data.size())
+        {
+            std::error_code ignored;
+            std::filesystem::resize_file(path, offset, ignored);   // drop the torn tail
+        }
+
+        log_ = std::fopen(path.c_str(), "ab");
+        if (log_ == NULL)
+        {
+            if (error) *error = "could not open " + path + " for appending";
+            return false;
+        }
+        return true;
+    }
+
+    // Commits anything pending and closes the log.
+    void close()
+    {
+        if (log_ == NULL) return;
+        commit();
+        std::fclose(log_);
+        log_ = NULL;
+    }
+
+    bool is_open() const { return log_ != NULL; }
+    std::size_t replayed() const { return replayed_; }
+
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return records_.size();
+    }
+
+    // The record itself; only valid while no other thread changes the store.
+    const Customer* find(std::string_view id) const
+    {
+        const std::size_t i = locate(id);
+        return i != npos ? &records_[i] : NULL;
+    }
+
+    bool contains(std::string_view id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return locate(id) != npos;
+    }
+
+    // Copies the record into out; safe while other threads change the store.
+    bool get(std::string_view id, Customer& out) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const std::size_t i = locate(id);
+        if (i == npos) return false;
+        out = records_[i];
+        return true;
+    }
+
+    // Adds a customer; false if the ID is empty, too long or already taken.
+    bool add(std::string_view id, std::string_view name, std::string_view company,
+        std::string_view service_plan = "Standard", std::string_view billing_address = "",
+        std::string_view contact = "", std::int32_t tier = 0)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (id.empty() || id.size() > sizeof(Customer::id) || locate(id) != npos) return false;
+        begin_record(Op::Create, id);
+        put_string(name);
+        put_string(company);
+        put_string(service_plan);
+        put_string(billing_address);
+        put_string(contact);
+        put_byte(static_cast<std::uint8_t>(clamp_tier(tier)));
+        return settle(finish_record(), lock);
+    }
+
+    bool set_service_plan(std::string_view id, std::string_view value) { return set_string(Op::SetServicePlan, id, value); }
+    bool set_billing_address(std::string_view id, std::string_view value) { return set_string(Op::SetBilling, id, value); }
+    bool set_contact(std::string_view id, std::string_view value) { return set_string(Op::SetContact, id, value); }
+
+    // Moves the customer delta tiers up or down, staying within the tier names.
+    bool change_tier(std::string_view id, int delta)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        const std::size_t i = locate(id);
+        if (i == npos) return false;
+        begin_record(Op::SetTier, id);
+        put_byte(static_cast<std::uint8_t>(clamp_tier(records_[i].tier + delta)));
+        return settle(finish_record(), lock);
+    }
+
+    // Writes every pending change to the log (and syncs it). True when all are on disk,
+    // including changes another thread's commit was already writing.
+    bool commit()
+    {
+        std::lock_guard<std::mutex> writer(commit_mutex_);
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (log_ == NULL) return false;
+            writing_.swap(pending_);
+        }
+        if (writing_.empty()) return true;
+        bool ok = std::fwrite(writing_.data(), 1, writing_.size(), log_) == writing_.size();
+        ok = std::fflush(log_) == 0 && ok;
+        if (options_.sync && ok)
+        {
+#if defined(_WIN32)
+            ok = _commit(_fileno(log_)) == 0;
+#else
+            ok = ::fsync(fileno(log_)) == 0;
+#endif
+        }
+        writing_.clear();
+        ++commits_;
+        return ok;
+    }
+
+    std::size_t commits() const
+    {
+        std::lock_guard<std::mutex> writer(commit_mutex_);
+        return commits_;
+    }
+
+private:
+    enum class Op : std::uint8_t { Create = 1, SetServicePlan, SetBilling, SetContact, SetTier };
+    enum class Queued { Failed, Held, Due, Unlogged };
+
+    struct Slot
+    {
+        std::uint32_t tag = 0;      // hash of the ID (never 0 for a used slot)
+        std::uint32_t index = 0;    // position in records_
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Log record: [u32 payload size][u32 payload checksum][payload]
+    // payload:    [u8 op][u8 id length][id][op-specific fields]
+    static constexpr std::size_t record_header = 8;
+
+    static std::uint32_t hash(std::string_view bytes)
+    {
+        std::uint32_t h = 2166136261u;
+        for (const unsigned char c : bytes)
+        {
+            h ^= c;
+            h *= 16777619u;
+        }
+        return h != 0 ? h : 1;
+    }
+
+    static std::int32_t clamp_tier(std::int32_t tier)
+    {
+        return std::max<std::int32_t>(0, std::min<std::int32_t>(customer_tier_count - 1, tier));
+    }
+
+    std::size_t locate(std::string_view id) const
+    {
+        if (id.empty() || id.size() > sizeof(Customer::id)) return npos;
+        const std::uint32_t tag = hash(id);
+        const std::size_t mask = index_.size() - 1;
+        for (std::size_t i = tag & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = index_[i];
+            if (slot.tag == 0) return npos;
+            if (slot.tag == tag && records_[slot.index].get_id() == id) return slot.index;
+        }
+    }
+
+    void insert_index(std::uint32_t tag, std::uint32_t index)
+    {
+        const std::size_t mask = index_.size() - 1;
+        std::size_t i = tag & mask;
+        while (index_[i].tag != 0) i = (i + 1) & mask;
+        index_[i] = Slot{ tag, index };
+    }
+
+    // Keeps the index at most half full.
+    void grow_index()
+    {
+        if (2 * (records_.size() + 1) <= index_.size()) return;
+        std::vector<Slot> old(index_.size() * 2);
+        old.swap(index_);
+        for (const Slot& slot : old)
+        {
+            if (slot.tag != 0) insert_index(slot.tag, slot.index);
+        }
+    }
+
+    bool set_string(Op op, std::string_view id, std::string_view value)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (locate(id) == npos) return false;
+        begin_record(op, id);
+        put_string(value);
+        return settle(finish_record(), lock);
+    }
+
+    // Releases the store, then commits if the group is due.
+    bool settle(Queued queued, std::unique_lock<std::shared_mutex>& lock)
+    {
+        lock.unlock();
+        if (queued == Queued::Due) return commit();
+        return queued != Queued::Failed;
+    }
+
+    void begin_record(Op op, std::string_view id)
+    {
+        record_.assign(record_header, '\0');
+        put_byte(static_cast<std::uint8_t>(op));
+        put_string(id);
+    }
+
+    void put_byte(std::uint8_t value) { record_.push_back(static_cast<char>(value)); }
+
+    // Strings longer than 255 bytes would not fit any field anyway.
+    void put_string(std::string_view value)
+    {
+        const std::size_t n = std::min<std::size_t>(value.size(), 255);
+        put_byte(static_cast<std::uint8_t>(n));
+        record_.append(value.data(), n);
+    }
+
+    // Applies the record to memory and queues it for the log; Due when the group should be
+    // committed, Unlogged when there is no log to queue it for.
+    Queued finish_record()
+    {
+        const std::uint32_t size = static_cast<std::uint32_t>(record_.size() - record_header);
+        const std::uint32_t checksum = hash(std::string_view(record_).substr(record_header));
+        std::memcpy(&record_[0], &size, 4);
+        std::memcpy(&record_[4], &checksum, 4);
+        bool applied = false;
+        apply_record(record_.data(), record_.size(), &applied);
+        if (!applied) return Queued::Failed;
+        if (log_ == NULL) return Queued::Unlogged;
+
+        if (pending_.empty()) oldest_pending_ = std::chrono::steady_clock::now();
+        pending_ += record_;
+        if (pending_.size() >= options_.commit_bytes
+            || std::chrono::steady_clock::now() - oldest_pending_ >= options_.commit_interval)
+        {
+            return Queued::Due;
+        }
+        return Queued::Held;
+    }
+
+    // Parses and applies one log record. Returns its length, or 0 if it is torn (cut short
+    // or failing its checksum). An intact record that does not apply (*applied == false) is
+    // skipped rather than ending the replay.
+    std::size_t apply_record(const char* data, std::size_t available, bool* applied = NULL)
+    {
+        if (applied) *applied = false;
+        if (available < record_header) return 0;
+        std::uint32_t size, checksum;
+        std::memcpy(&size, data, 4);
+        std::memcpy(&checksum, data + 4, 4);
+        if (size < 2 || available - record_header < size) return 0;
+        const std::string_view payload(data + record_header, size);
+        if (hash(payload) != checksum) return 0;
+
+        std::size_t at = 0;
+        bool ok = true;
+        auto byte = [&]() -> std::uint8_t {
+            if (at >= payload.size()) { ok = false; return 0; }
+            return static_cast<std::uint8_t>(payload[at++]);
+        };
+        auto string = [&]() -> std::string_view {
+            const std::size_t n = byte();
+            if (!ok || payload.size() - at < n) { ok = false; return std::string_view(); }
+            const std::string_view s = payload.substr(at, n);
+            at += n;
+            return s;
+        };
+
+        const std::size_t length = record_header + size;
+        const Op op = static_cast<Op>(byte());
+        const std::string_view id = string();
+        if (!ok || id.empty() || id.size() > sizeof(Customer::id)) return length;
+
+        if (op == Op::Create)
+        {
+            Customer c{};
+            Customer::set(c.id, id);
+            Customer::set(c.name, string());
+            Customer::set(c.company, string());
+            Customer::set(c.service_plan, string());
+            Customer::set(c.billing_address, string());
+            Customer::set(c.contact, string());
+            c.tier = clamp_tier(byte());
+            if (!ok || locate(id) != npos) return length;
+            grow_index();
+            records_.push_back(c);
+            insert_index(hash(id), static_cast<std::uint32_t>(records_.size() - 1));
+            if (applied) *applied = true;
+            return length;
+        }
+
+        const std::size_t i = locate(id);
+        if (i == npos) return length;
+        Customer& c = records_[i];
+        switch (op)
+        {
+        case Op::SetServicePlan:
+        case Op::SetBilling:
+        case Op::SetContact:
+        {
+            const std::string_view value = string();
+            if (!ok) return length;
+            if (op == Op::SetServicePlan) Customer::set(c.service_plan, value);
+            else if (op == Op::SetBilling) Customer::set(c.billing_address, value);
+            else Customer::set(c.contact, value);
+            break;
+        }
+        case Op::SetTier:
+        {
+            const std::int32_t tier = byte();
+            if (!ok) return length;
+            c.tier = clamp_tier(tier);
+            break;
+        }
+        default:
+            return length;
+        }
+        if (applied) *applied = true;
+        return length;
+    }
+
+    Options options_;
+    std::vector<Customer> records_;
+    std::vector<Slot> index_ = std::vector<Slot>(16);
+    std::FILE* log_ = NULL;
+    std::string record_;                 // record being built
+    std::string pending_;                // records not yet committed
+    std::string writing_;                // records the current commit is writing
+    mutable std::shared_mutex mutex_;    // records_, index_, record_, pending_
+    mutable std::mutex commit_mutex_;    // writing_, commits_, one commit at a time
+    std::chrono::steady_clock::time_point oldest_pending_;
+    std::size_t replayed_ = 0;
+    std::size_t commits_ = 0;
+};
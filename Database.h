@@ -0,0 +1,166 @@
+// Database.h : Opening tuned SQLite databases and loading rows in bulk.
+//
+// initialize_database concatenates INSERT statements into one sqlite3_exec string and
+// runs them without an explicit transaction, so SQLite parses every statement and
+// commits after each row. bulk_insert wraps the whole load in BEGIN/COMMIT and steps
+// one prepared INSERT per row instead.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "sqlite3.h"
+
+struct DatabaseOptions
+{
+    std::string path = ":memory:";  // file name or "file:" URI
+    bool wal = true;                // journal_mode=WAL (ignored by in-memory databases)
+    bool bulk_load = false;         // synchronous=OFF and an exclusive lock while seeding;
+                                    // call finish_bulk_load once the rows are in
+    int cache_size_kib = 64 * 1024; // page cache size
+    long long mmap_size = 256LL * 1024 * 1024;
+    int extra_open_flags = 0;       // e.g. SQLITE_OPEN_NOMUTEX
+};
+
+// Runs one statement and reports SQLite's message on failure.
+inline bool exec_sql(sqlite3* db, const std::string& sql, std::string* error = NULL)
+{
+    char* error_message = NULL;
+    if (sqlite3_exec(db, sql.c_str(), NULL, NULL, &error_message) != SQLITE_OK)
+    {
+        if (error != NULL) *error = error_message ? error_message : sqlite3_errmsg(db);
+        sqlite3_free(error_message);
+        return false;
+    }
+    return true;
+}
+
+// Opens (creating if needed) the database described by options and applies the pragmas.
+// On failure *db is closed and set to NULL, and error (if given) holds the reason.
+inline bool open_database(const DatabaseOptions& options, sqlite3** db, std::string* error = NULL)
+{
+    const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | options.extra_open_flags;
+    if (sqlite3_open_v2(options.path.c_str(), db, flags, NULL) != SQLITE_OK)
+    {
+        if (error != NULL) *error = *db ? sqlite3_errmsg(*db) : "out of memory";
+        sqlite3_close(*db);
+        *db = NULL;
+        return false;
+    }
+
+    std::string pragmas = "PRAGMA temp_store=MEMORY;";
+    pragmas += "PRAGMA cache_size=-" + std::to_string(options.cache_size_kib) + ";";
+    pragmas += "PRAGMA mmap_size=" + std::to_string(options.mmap_size) + ";";
+    // WAL waits for finish_bulk_load: a connection that holds the exclusive lock when it
+    // first reads a WAL database keeps that lock until it leaves WAL mode.
+    if (options.wal && !options.bulk_load) pragmas += "PRAGMA journal_mode=WAL;";
+    pragmas += options.bulk_load ? "PRAGMA synchronous=OFF;PRAGMA locking_mode=EXCLUSIVE;" : "PRAGMA synchronous=NORMAL;";
+
+    if (!exec_sql(*db, pragmas, error))
+    {
+        sqlite3_close(*db);
+        *db = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Ends the bulk_load settings open_database applied with options: synchronous and
+// locking_mode go back to NORMAL, and WAL is turned on if options ask for it. SQLite only
+// drops an exclusive lock at the next access to the database, so a read follows to
+// release it and let other connections in.
+inline bool finish_bulk_load(sqlite3* db, const DatabaseOptions& options, std::string* error = NULL)
+{
+    std::string pragmas = "PRAGMA synchronous=NORMAL;PRAGMA locking_mode=NORMAL;SELECT 1 FROM sqlite_master LIMIT 1;";
+    if (options.wal) pragmas += "PRAGMA journal_mode=WAL;";
+    return exec_sql(db, pragmas, error);
+}
+
+struct BulkInsertStats
+{
+    std::size_t rows = 0;
+    double seconds = 0.0;
+
+    double rows_per_second() const { return seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0; }
+};
+
+namespace bulk_detail
+{
+    inline int bind_value(sqlite3_stmt* stmt, int index, std::string_view value)
+    {
+        return sqlite3_bind_text(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    int bind_value(sqlite3_stmt* stmt, int index, T value)
+    {
+        return sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value));
+    }
+
+    template <typename Tuple, std::size_t... I>
+    int bind_tuple(sqlite3_stmt* stmt, const Tuple& row, std::index_sequence<I...>)
+    {
+        int result = SQLITE_OK;
+        // stop at the first failing bind
+        ((result == SQLITE_OK ? (result = bind_value(stmt, static_cast<int>(I + 1), std::get<I>(row))) : result), ...);
+        return result;
+    }
+}
+
+// Inserts every tuple in [first, last) with `insert_sql` (one '?' per tuple element) inside
+// a single transaction. The statement is prepared once and reset between rows. On failure
+// the transaction is rolled back and error (if given) holds the reason.
+template <typename Iterator>
+bool bulk_insert(sqlite3* db, const std::string& insert_sql, Iterator first, Iterator last,
+    BulkInsertStats& stats, std::string* error = NULL)
+{
+    using Row = typename std::iterator_traits<Iterator>::value_type;
+    const auto started = std::chrono::steady_clock::now();
+    stats = BulkInsertStats();
+
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(db, insert_sql.c_str(), static_cast<int>(insert_sql.size()), &stmt, NULL) != SQLITE_OK)
+    {
+        if (error != NULL) *error = sqlite3_errmsg(db);
+        return false;
+    }
+
+    if (!exec_sql(db, "BEGIN", error))
+    {
+        sqlite3_finalize(stmt);
+        return false;
+    }
+
+    for (; first != last; ++first)
+    {
+        if (bulk_detail::bind_tuple(stmt, *first, std::make_index_sequence<std::tuple_size_v<Row>>()) != SQLITE_OK
+            || sqlite3_step(stmt) != SQLITE_DONE)
+        {
+            if (error != NULL) *error = sqlite3_errmsg(db);
+            sqlite3_finalize(stmt);
+            exec_sql(db, "ROLLBACK");
+            return false;
+        }
+        sqlite3_reset(stmt);
+        ++stats.rows;
+    }
+    sqlite3_finalize(stmt);
+
+    if (!exec_sql(db, "COMMIT", error))
+    {
+        exec_sql(db, "ROLLBACK");
+        return false;
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return true;
+}
@@ -0,0 +1,424 @@
+// EventLog.h : Structured, low-overhead event logging shared by all four programs.
+//
+//   EVENT_WARN("sql_injection_rejected", event_log::field("reason", describe(verdict)),
+//       event_log::field("sql", sql));
+//
+// A call copies the event name (a string literal), a timestamp and its fields (integers,
+// floating point, bools and strings, copied) into a fixed-size binary record in a ring
+// buffer owned by the calling thread: no lock, no allocation, no formatting and no I/O,
+// so it costs tens of nanoseconds. A background thread drains every ring a few times a
+// second, formats the records as one logfmt line each, in time order, and writes them
+// with one fwrite and fflush per pass. Strings that do not fit a record are cut short;
+// when a thread outruns the flusher its ring fills and further records are dropped
+// (counted, and reported as a log_records_dropped event) rather than blocking the caller.
+//
+// Records go to the file named by the EVENT_LOG_PATH environment variable (appended), or
+// to stderr. Everything still buffered is written when the program exits normally.
+//
+// EVENT_LOG_LEVEL picks the lowest level compiled in (EVENT_LOG_LEVEL_TRACE .. _ERROR, or
+// EVENT_LOG_LEVEL_OFF); the macros for levels below it expand to nothing, so their
+// arguments are not even evaluated.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define EVENT_LOG_LEVEL_TRACE 0
+#define EVENT_LOG_LEVEL_DEBUG 1
+#define EVENT_LOG_LEVEL_INFO 2
+#define EVENT_LOG_LEVEL_WARN 3
+#define EVENT_LOG_LEVEL_ERROR 4
+#define EVENT_LOG_LEVEL_OFF 5
+
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL EVENT_LOG_LEVEL_INFO
+#endif
+
+namespace event_log
+{
+    enum class Level : std::uint8_t { Trace, Debug, Info, Warn, Error };
+
+    inline const char* level_name(Level level)
+    {
+        static const char* const names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+        return names[static_cast<int>(level)];
+    }
+
+    // One key=value pair of an event; the key must outlive the program (a literal).
+    template <typename T>
+    struct Field
+    {
+        const char* key;
+        T value;
+    };
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    Field<T> field(const char* key, T value) { return Field<T>{ key, value }; }
+
+    inline Field<std::string_view> field(const char* key, std::string_view value) { return { key, value }; }
+    inline Field<std::string_view> field(const char* key, const std::string& value) { return { key, value }; }
+    inline Field<std::string_view> field(const char* key, const char* value) { return { key, value != NULL ? value : "" }; }
+
+    namespace detail
+    {
+        enum class Type : std::uint8_t { Int, UInt, Double, LongDouble, Bool, String };
+
+        constexpr std::size_t record_size = 256;
+
+        struct Record
+        {
+            std::int64_t time_ns;        // system_clock, since the epoch
+            const char* event;
+            std::uint32_t thread;
+            Level level;
+            std::uint8_t fields;
+            std::uint16_t used;          // bytes of payload
+            char payload[record_size - 24];
+        };
+
+        static_assert(sizeof(Record) == record_size, "Record layout");
+
+        constexpr std::size_t ring_capacity = 512;   // records per thread (128 KiB)
+
+        // Single producer (its thread), single consumer (the flusher).
+        struct Ring
+        {
+            alignas(64) std::atomic<std::size_t> head{ 0 };   // next record to write
+            alignas(64) std::atomic<std::size_t> tail{ 0 };   // next record to flush
+            std::atomic<std::size_t> dropped{ 0 };
+            std::atomic<bool> retired{ false };              // its thread has exited
+            std::uint32_t thread = 0;
+            Record records[ring_capacity];
+        };
+
+        // Appends a field to the record; false (and nothing written) when it does not fit.
+        inline bool put(Record& record, const char* key, Type type, const void* value, std::size_t size)
+        {
+            const std::size_t header = sizeof(key) + 1;
+            if (record.used + header + size > sizeof(record.payload)) return false;
+            char* at = record.payload + record.used;
+            std::memcpy(at, &key, sizeof(key));
+            at[sizeof(key)] = static_cast<char>(type);
+            std::memcpy(at + header, value, size);
+            record.used = static_cast<std::uint16_t>(record.used + header + size);
+            ++record.fields;
+            return true;
+        }
+
+        template <typename T>
+        void put(Record& record, const Field<T>& f)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                const std::uint8_t b = f.value ? 1 : 0;
+                put(record, f.key, Type::Bool, &b, 1);
+            }
+            else if constexpr (std::is_same_v<T, long double>)
+            {
+                // kept at full width: numeric_overflow's long double values overflow a double
+                put(record, f.key, Type::LongDouble, &f.value, sizeof(long double));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                const double d = static_cast<double>(f.value);
+                put(record, f.key, Type::Double, &d, sizeof(d));
+            }
+            else if constexpr (std::is_signed_v<T>)
+            {
+                const std::int64_t i = static_cast<std::int64_t>(f.value);
+                put(record, f.key, Type::Int, &i, sizeof(i));
+            }
+            else
+            {
+                const std::uint64_t u = static_cast<std::uint64_t>(f.value);
+                put(record, f.key, Type::UInt, &u, sizeof(u));
+            }
+        }
+
+        // Strings are stored as [u8 length][bytes], cut to what is left of the record.
+        inline void put(Record& record, const Field<std::string_view>& f)
+        {
+            const std::size_t header = sizeof(f.key) + 1;
+            const std::size_t room = sizeof(record.payload) - record.used;
+            if (room < header + 1) return;
+            const std::size_t n = std::min<std::size_t>({ f.value.size(), room - header - 1, 255 });
+            char* at = record.payload + record.used;
+            std::memcpy(at, &f.key, sizeof(f.key));
+            at[sizeof(f.key)] = static_cast<char>(Type::String);
+            at[header] = static_cast<char>(n);
+            std::memcpy(at + header + 1, f.value.data(), n);
+            record.used = static_cast<std::uint16_t>(record.used + header + 1 + n);
+            ++record.fields;
+        }
+
+        class Logger
+        {
+        public:
+            static Logger& instance()
+            {
+                static Logger logger;
+                return logger;
+            }
+
+            std::shared_ptr<Ring> attach()
+            {
+                std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> lock(rings_mutex_);
+                ring->thread = ++threads_;
+                rings_.push_back(ring);
+                return ring;
+            }
+
+            ~Logger()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mutex_);
+                    stopping_ = true;
+                }
+                wake_.notify_one();
+                if (flusher_.joinable()) flusher_.join();
+                drain();   // anything written since the flusher's last pass
+                if (sink_ != stderr) std::fclose(sink_);
+            }
+
+        private:
+            Logger()
+            {
+                const char* path = std::getenv("EVENT_LOG_PATH");
+                if (path != NULL && *path != '\0') sink_ = std::fopen(path, "ab");
+                if (sink_ == NULL) sink_ = stderr;
+                flusher_ = std::thread([this]() { run(); });
+            }
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                while (!stopping_)
+                {
+                    wake_.wait_for(lock, std::chrono::milliseconds(100));
+                    lock.unlock();
+                    drain();
+                    lock.lock();
+                }
+            }
+
+            // Formats every published record, in time order, and writes them in one go.
+            void drain()
+            {
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard<std::mutex> lock(rings_mutex_);
+                    rings = rings_;
+                }
+
+                batch_.clear();
+                heads_.clear();
+                std::size_t dropped = 0;
+                for (const std::shared_ptr<Ring>& ring : rings)
+                {
+                    const std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+                    const std::size_t head = ring->head.load(std::memory_order_acquire);
+                    for (std::size_t i = tail; i != head; ++i) batch_.push_back(&ring->records[i % ring_capacity]);
+                    heads_.push_back(head);
+                    dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+                }
+                std::stable_sort(batch_.begin(), batch_.end(),
+                    [](const Record* a, const Record* b) { return a->time_ns < b->time_ns; });
+
+                text_.clear();
+                for (const Record* record : batch_) format(*record);
+                if (dropped != 0) format_dropped(dropped);
+                if (!text_.empty())
+                {
+                    std::fwrite(text_.data(), 1, text_.size(), sink_);
+                    std::fflush(sink_);
+                }
+
+                // Hand the slots back, then forget rings whose threads have gone and are empty.
+                for (std::size_t i = 0; i < rings.size(); ++i) rings[i]->tail.store(heads_[i], std::memory_order_release);
+                std::lock_guard<std::mutex> lock(rings_mutex_);
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& ring) {
+                    return ring->retired.load(std::memory_order_acquire)
+                        && ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed);
+                }), rings_.end());
+            }
+
+            void format_time(std::int64_t time_ns)
+            {
+                const std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+                std::tm utc{};
+#if defined(_WIN32)
+                gmtime_s(&utc, &seconds);
+#else
+                gmtime_r(&seconds, &utc);
+#endif
+                char text[40];
+                const std::size_t n = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+                text_.append(text, n);
+                std::snprintf(text, sizeof(text), ".%06lldZ", static_cast<long long>(time_ns % 1000000000 / 1000));
+                text_ += text;
+            }
+
+            void format_string(std::string_view value)
+            {
+                text_ += '"';
+                for (const char c : value)
+                {
+                    if (c == '"' || c == '\\') { text_ += '\\'; text_ += c; }
+                    else if (c == '\n') text_ += "\\n";
+                    else if (c == '\r') text_ += "\\r";
+                    else if (static_cast<unsigned char>(c) < 0x20) text_ += '?';
+                    else text_ += c;
+                }
+                text_ += '"';
+            }
+
+            void format(const Record& record)
+            {
+                char number[48];
+                format_time(record.time_ns);
+                text_ += ' ';
+                text_ += level_name(record.level);
+                text_ += " event=";
+                text_ += record.event;
+                std::snprintf(number, sizeof(number), " thread=%u", record.thread);
+                text_ += number;
+
+                const char* at = record.payload;
+                for (std::uint8_t i = 0; i < record.fields; ++i)
+                {
+                    const char* key;
+                    std::memcpy(&key, at, sizeof(key));
+                    const Type type = static_cast<Type>(at[sizeof(key)]);
+                    at += sizeof(key) + 1;
+                    text_ += ' ';
+                    text_ += key;
+                    text_ += '=';
+                    switch (type)
+                    {
+                    case Type::Int: { std::int64_t v; std::memcpy(&v, at, 8); at += 8; std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(v)); text_ += number; break; }
+                    case Type::UInt: { std::uint64_t v; std::memcpy(&v, at, 8); at += 8; std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(v)); text_ += number; break; }
+                    case Type::Double: { double v; std::memcpy(&v, at, 8); at += 8; std::snprintf(number, sizeof(number), "%.17g", v); text_ += number; break; }
+                    case Type::LongDouble: { long double v; std::memcpy(&v, at, sizeof(v)); at += sizeof(v); std::snprintf(number, sizeof(number), "%.21Lg", v); text_ += number; break; }
+                    case Type::Bool: text_ += *at != 0 ? "true" : "false"; at += 1; break;
+                    case Type::String:
+                    {
+                        const std::size_t n = static_cast<unsigned char>(*at);
+                        format_string(std::string_view(at + 1, n));
+                        at += n + 1;
+                        break;
+                    }
+                    }
+                }
+                text_ += '\n';
+            }
+
+            void format_dropped(std::size_t dropped)
+            {
+                format_time(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+                text_ += " WARN event=log_records_dropped count=" + std::to_string(dropped) + '\n';
+            }
+
+            std::mutex rings_mutex_;
+            std::vector<std::shared_ptr<Ring>> rings_;
+            std::uint32_t threads_ = 0;
+
+            std::mutex wake_mutex_;
+            std::condition_variable wake_;
+            bool stopping_ = false;
+            std::thread flusher_;
+
+            std::FILE* sink_ = NULL;
+            std::vector<const Record*> batch_;   // flusher only
+            std::vector<std::size_t> heads_;     // flusher only
+            std::string text_;                   // flusher only
+        };
+
+        // The calling thread's ring, registered on first use and retired when it exits.
+        struct ThreadRing
+        {
+            std::shared_ptr<Ring> ring = Logger::instance().attach();
+
+            ~ThreadRing()
+            {
+                ring->retired.store(true, std::memory_order_release);
+            }
+        };
+
+        inline Ring& this_thread_ring()
+        {
+            thread_local ThreadRing local;
+            return *local.ring;
+        }
+    }
+
+    template <typename... Values>
+    void emit(Level level, const char* event, const Field<Values>&... fields)
+    {
+        detail::Ring& ring = detail::this_thread_ring();
+        const std::size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) == detail::ring_capacity)
+        {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        detail::Record& record = ring.records[head % detail::ring_capacity];
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.event = event;
+        record.thread = ring.thread;
+        record.level = level;
+        record.fields = 0;
+        record.used = 0;
+        (detail::put(record, fields), ...);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+}
+
+#if EVENT_LOG_LEVEL <= EVENT_LOG_LEVEL_TRACE
+#define EVENT_TRACE(...) ::event_log::emit(::event_log::Level::Trace, __VA_ARGS__)
+#else
+#define EVENT_TRACE(...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= EVENT_LOG_LEVEL_DEBUG
+#define EVENT_DEBUG(...) ::event_log::emit(::event_log::Level::Debug, __VA_ARGS__)
+#else
+#define EVENT_DEBUG(...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= EVENT_LOG_LEVEL_INFO
+#define EVENT_INFO(...) ::event_log::emit(::event_log::Level::Info, __VA_ARGS__)
+#else
+#define EVENT_INFO(...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= EVENT_LOG_LEVEL_WARN
+#define EVENT_WARN(...) ::event_log::emit(::event_log::Level::Warn, __VA_ARGS__)
+#else
+#define EVENT_WARN(...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= EVENT_LOG_LEVEL_ERROR
+#define EVENT_ERROR(...) ::event_log::emit(::event_log::Level::Error, __VA_ARGS__)
+#else
+#define EVENT_ERROR(...) ((void)0)
+#endif
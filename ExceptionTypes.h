@@ -0,0 +1,316 @@
+// ExceptionTypes.h : The exceptions module's error types, shared with its benchmarks.
+//
+// Error / Result<T> report failures as ordinary return values; CustomException and its
+// subclasses are the allocation-free exception hierarchy; throw_error() turns an Error
+// into the matching exception. PROFILED_THROW / PROFILE_CATCH feed the optional exception
+// profiler. EXCEPTION_PROFILING changes ExceptionInfo's layout, so every translation
+// unit of a program must see the same value: set it from the build (CMake option
+// CS405_EXCEPTION_PROFILING), not in a source file.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Throw/catch counters and timing (see exception_profiler below); off unless the build
+// asks for them, since they take a global mutex on every throw and catch.
+#ifndef EXCEPTION_PROFILING
+#define EXCEPTION_PROFILING 0
+#endif
+
+// Why a non-throwing operation failed.
+enum class ErrorCode {
+    None,
+    Custom,
+    DivisionByZero,
+    LogicFailed
+};
+
+// A lightweight error: a code plus a pointer to a static message. Copying or returning
+// it never allocates, unlike building a std::exception with a std::string inside.
+struct Error {
+    ErrorCode code{ ErrorCode::None };
+    const char* message{ "" };
+};
+
+constexpr Error custom_error{ ErrorCode::Custom, "Custom Exception Thrown!" };
+constexpr Error division_by_zero_error{ ErrorCode::DivisionByZero, "Division by zero is not allowed." };
+constexpr Error logic_failed_error{ ErrorCode::LogicFailed, "Something went wrong in even more custom logic." };
+
+// Value-or-error result in the style of std::expected: either holds a T or an Error.
+// Failure is an ordinary return, so the common error path costs no unwinding.
+template <typename T>
+class Result {
+public:
+    Result(T value) : value_(std::move(value)), has_value_(true) {}
+    Result(Error error) : error_(error), has_value_(false) {}
+
+    bool has_value() const noexcept { return has_value_; }
+    explicit operator bool() const noexcept { return has_value_; }
+
+    // Only meaningful when has_value().
+    const T& value() const noexcept { return value_; }
+    const T& operator*() const noexcept { return value_; }
+
+    // Only meaningful when !has_value().
+    const Error& error() const noexcept { return error_; }
+
+    T value_or(T fallback) const { return has_value_ ? value_ : std::move(fallback); }
+
+private:
+    T value_{};
+    Error error_{};
+    bool has_value_;
+};
+
+// The code, static message and formatted context that every exception of this module
+// carries. Context, when a subclass adds some, goes into a fixed inline buffer (cut short if
+// it does not fit). Constructing or copying one therefore never allocates, unlike
+// std::runtime_error, which copies its message onto the heap - so it is safe to throw under
+// memory pressure. (The C++ runtime still places the thrown object itself; it falls back to
+// an emergency pool when the heap is exhausted.)
+class ExceptionInfo {
+public:
+    static constexpr std::size_t context_capacity = 96;
+
+    ErrorCode code() const noexcept { return code_; }
+    // The static message, without any formatted context.
+    std::string_view message() const noexcept { return message_; }
+    // What what() returns: the message with its context.
+    const char* text() const noexcept {
+        return context_[0] != '\0' ? context_ : message_;
+    }
+
+#if EXCEPTION_PROFILING
+    // When PROFILED_THROW threw this exception (steady clock, ns); 0 if it did not.
+    std::int64_t thrown_at_ns() const noexcept { return thrown_at_ns_; }
+    void mark_thrown(std::int64_t now_ns) noexcept { thrown_at_ns_ = now_ns; }
+#endif
+
+protected:
+    explicit ExceptionInfo(const Error& error) noexcept : code_(error.code), message_(error.message) {}
+    ~ExceptionInfo() = default;
+
+    // Formats "<message> (<context>)" into the inline buffer with snprintf; the context is
+    // cut short when it does not fit, and dropped when the message alone fills the buffer.
+    template <typename... Args>
+    void set_context(const char* format, Args... args) noexcept {
+        const int used = std::snprintf(context_, sizeof(context_), "%s (", message_);
+        if (used < 0 || static_cast<std::size_t>(used) + 2 > sizeof(context_)) {
+            context_[0] = '\0';
+            return;
+        }
+        const std::size_t room = sizeof(context_) - static_cast<std::size_t>(used) - 1;  // keeps one byte for ')'
+        const int added = std::snprintf(context_ + used, room, format, args...);
+        const std::size_t end = static_cast<std::size_t>(used)
+            + (added < 0 ? 0 : std::min(static_cast<std::size_t>(added), room - 1));
+        context_[end] = ')';
+        context_[end + 1] = '\0';
+    }
+
+private:
+    ErrorCode code_;
+    const char* message_;
+    char context_[context_capacity]{};
+#if EXCEPTION_PROFILING
+    std::int64_t thrown_at_ns_{ 0 };
+#endif
+};
+
+// A custom exception class derived from std::exception, and the root of the module's
+// exception hierarchy: catch (const CustomException&) catches every exception it throws.
+// The subclasses do not also derive from std::invalid_argument or std::runtime_error,
+// whose message string may be allocated; catch them as CustomException or std::exception.
+class CustomException : public std::exception, public ExceptionInfo {
+public:
+    CustomException() noexcept : CustomException(custom_error) {}
+    explicit CustomException(const Error& error) noexcept : ExceptionInfo(error) {}
+
+    const char* what() const noexcept override { return text(); }
+};
+
+class DivisionByZeroException : public CustomException {
+public:
+    DivisionByZeroException() noexcept : CustomException(division_by_zero_error) {}
+    explicit DivisionByZeroException(float numerator) noexcept : CustomException(division_by_zero_error) {
+        set_context("numerator = %g", static_cast<double>(numerator));
+    }
+};
+
+class LogicFailedException : public CustomException {
+public:
+    LogicFailedException() noexcept : CustomException(logic_failed_error) {}
+};
+
+/*
+    Exception profiling.
+
+    Throw sites use PROFILED_THROW(Type, args...) and handlers call PROFILE_CATCH(e) (or
+    PROFILE_CATCH_ALL() in catch (...)). The profiler counts throws per exception type and
+    per site, catches per site, and the time from throw to each catch, which goes into a
+    log2 histogram. The report is written to std::cerr when the program exits. Tables are
+    fixed-size, so profiling adds no allocation to a throw; types or sites beyond the first
+    max_entries are counted as "(other)". Without -DEXCEPTION_PROFILING=1 the macros are a
+    plain throw and nothing.
+*/
+#if EXCEPTION_PROFILING
+namespace exception_profiler {
+    constexpr std::size_t max_entries = 32;
+    constexpr std::size_t histogram_buckets = 40;   // bucket b: [2^(b-1), 2^b) ns
+
+    struct Site {
+        const char* function;
+        int line;
+    };
+
+    inline std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    class Profile {
+    public:
+        ~Profile() {
+            dump(std::cerr);
+        }
+
+        void record_throw(const char* type, Site site) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bump(types_, type_count_, Site{ type, 0 }, -1);
+            bump(throw_sites_, throw_site_count_, site, -1);
+        }
+
+        // thrown_at_ns is 0 when the exception was not thrown through PROFILED_THROW.
+        void record_catch(Site site, std::int64_t thrown_at_ns) {
+            const std::int64_t elapsed = thrown_at_ns != 0 ? now_ns() - thrown_at_ns : -1;
+            std::lock_guard<std::mutex> lock(mutex_);
+            bump(catch_sites_, catch_site_count_, site, elapsed);
+            if (elapsed >= 0) {
+                std::size_t bucket = 0;
+                for (std::uint64_t v = static_cast<std::uint64_t>(elapsed); v != 0; v >>= 1) ++bucket;
+                ++histogram_[std::min(bucket, histogram_buckets - 1)];
+            }
+        }
+
+        void dump(std::ostream& out) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (type_count_ == 0 && catch_site_count_ == 0) return;
+
+            out << "Exception profile:" << std::endl;
+            out << "  throws by type:" << std::endl;
+            print(out, types_, type_count_, false);
+            out << "  throws by site:" << std::endl;
+            print(out, throw_sites_, throw_site_count_, false);
+            out << "  catches by site (mean throw-to-catch time):" << std::endl;
+            print(out, catch_sites_, catch_site_count_, true);
+
+            out << "  throw-to-catch histogram:" << std::endl;
+            unsigned long long largest = 0;
+            for (const auto count : histogram_) largest = std::max(largest, count);
+            for (std::size_t b = 0; b < histogram_buckets; ++b) {
+                if (histogram_[b] == 0) continue;
+                const unsigned long long low = b == 0 ? 0 : 1ull << (b - 1);
+                const std::size_t bar = static_cast<std::size_t>((histogram_[b] * 40 + largest - 1) / largest);
+                out << "    [" << low << ", " << (1ull << b) << ") ns\t" << histogram_[b] << "\t" << std::string(bar, '#') << std::endl;
+            }
+        }
+
+    private:
+        struct Entry {
+            Site site{ nullptr, 0 };
+            unsigned long long count{ 0 };
+            unsigned long long timed{ 0 };
+            long long total_ns{ 0 };
+        };
+
+        // elapsed_ns < 0: nothing to time
+        static void bump(Entry* table, std::size_t& used, Site site, std::int64_t elapsed_ns) {
+            std::size_t i = 0;
+            while (i < used && !(table[i].site.line == site.line && std::strcmp(table[i].site.function, site.function) == 0)) ++i;
+            if (i == used) {
+                if (used < max_entries - 1) ++used;
+                else { i = max_entries - 1; site = Site{ "(other)", 0 }; used = max_entries; }
+                if (table[i].site.function == nullptr) table[i].site = site;
+            }
+            ++table[i].count;
+            if (elapsed_ns >= 0) {
+                ++table[i].timed;
+                table[i].total_ns += elapsed_ns;
+            }
+        }
+
+        static void print(std::ostream& out, const Entry* table, std::size_t used, bool timing) {
+            for (std::size_t i = 0; i < used; ++i) {
+                out << "    " << table[i].site.function;
+                if (table[i].site.line != 0) out << ":" << table[i].site.line;
+                out << "\t" << table[i].count;
+                if (timing && table[i].timed != 0) out << "\t" << table[i].total_ns / static_cast<long long>(table[i].timed) << " ns";
+                out << std::endl;
+            }
+        }
+
+        mutable std::mutex mutex_;
+        Entry types_[max_entries];
+        Entry throw_sites_[max_entries];
+        Entry catch_sites_[max_entries];
+        std::size_t type_count_{ 0 };
+        std::size_t throw_site_count_{ 0 };
+        std::size_t catch_site_count_{ 0 };
+        unsigned long long histogram_[histogram_buckets]{};
+    };
+
+    inline Profile& profile() {
+        static Profile instance;
+        return instance;
+    }
+
+    // Records the throw, stamps the exception and throws it.
+    template <typename E>
+    [[noreturn]] void throw_at(E exception, const char* type, Site site) {
+        profile().record_throw(type, site);
+        if constexpr (std::is_base_of_v<ExceptionInfo, E>) exception.mark_thrown(now_ns());
+        throw exception;
+    }
+
+    inline void caught(const std::exception& e, Site site) {
+        const auto* info = dynamic_cast<const ExceptionInfo*>(&e);
+        profile().record_catch(site, info != nullptr ? info->thrown_at_ns() : 0);
+    }
+
+    inline void caught_unknown(Site site) {
+        profile().record_catch(site, 0);
+    }
+}
+#endif
+
+#if EXCEPTION_PROFILING
+#define EXCEPTION_SITE (exception_profiler::Site{ __func__, __LINE__ })
+#define PROFILED_THROW(Type, ...) exception_profiler::throw_at(Type(__VA_ARGS__), #Type, EXCEPTION_SITE)
+#define PROFILE_CATCH(e) exception_profiler::caught((e), EXCEPTION_SITE)
+#define PROFILE_CATCH_ALL() exception_profiler::caught_unknown(EXCEPTION_SITE)
+#else
+#define PROFILED_THROW(Type, ...) throw Type(__VA_ARGS__)
+#define PROFILE_CATCH(e) ((void)0)
+#define PROFILE_CATCH_ALL() ((void)0)
+#endif
+
+// Builds the exception that reports error, most specific type first.
+[[noreturn]] inline void throw_error(const Error& error) {
+    switch (error.code) {
+    case ErrorCode::DivisionByZero: PROFILED_THROW(DivisionByZeroException);
+    case ErrorCode::LogicFailed: PROFILED_THROW(LogicFailedException);
+    default: PROFILED_THROW(CustomException, error);
+    }
+}
@@ -0,0 +1,106 @@
+// ExceptionTypesTest.cpp : Checks of the exceptions module's hierarchy.
+//
+// Every exception throw_error() raises must be caught by catch (const CustomException&)
+// and by catch (const std::exception&), keep its code and message, and be built and
+// copied without touching the heap (global operator new is counted here). Exits non-zero
+// on the first failure. Run by ctest (test exception_types).
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <string_view>
+
+#include "ExceptionTypes.h"
+
+namespace
+{
+    int failures = 0;
+    unsigned long allocations = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++failures;
+        }
+    }
+
+    // The code that reached catch (const CustomException&), or None if something else did.
+    ErrorCode caught_as_custom(const Error& error)
+    {
+        try
+        {
+            throw_error(error);
+        }
+        catch (const CustomException& e)
+        {
+            return e.code();
+        }
+        catch (...)
+        {
+        }
+        return ErrorCode::None;
+    }
+
+    // The what() that reached catch (const std::exception&), or "" if something else did.
+    std::string_view caught_as_standard(const Error& error)
+    {
+        try
+        {
+            throw_error(error);
+        }
+        catch (const std::exception& e)
+        {
+            return e.what();
+        }
+        catch (...)
+        {
+        }
+        return "";
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main()
+{
+    expect(caught_as_custom(division_by_zero_error) == ErrorCode::DivisionByZero, "DivisionByZeroException is a CustomException");
+    expect(caught_as_custom(logic_failed_error) == ErrorCode::LogicFailed, "LogicFailedException is a CustomException");
+    expect(caught_as_custom(custom_error) == ErrorCode::Custom, "CustomException itself");
+    expect(caught_as_standard(division_by_zero_error) == division_by_zero_error.message, "DivisionByZeroException is a std::exception");
+    expect(caught_as_standard(logic_failed_error) == logic_failed_error.message, "LogicFailedException is a std::exception");
+
+    try
+    {
+        PROFILED_THROW(DivisionByZeroException, 10.0f);
+    }
+    catch (const DivisionByZeroException& e)
+    {
+        expect(std::string_view(e.what()) == "Division by zero is not allowed. (numerator = 10)", "context in what()");
+        expect(e.message() == division_by_zero_error.message, "message() without the context");
+    }
+
+    const unsigned long before = allocations;
+    {
+        const DivisionByZeroException original(3.0f);
+        const DivisionByZeroException copy = original;
+        const LogicFailedException logic;
+        const CustomException custom(logic_failed_error);
+        expect(std::string_view(copy.what()) == original.what() && logic.code() == custom.code(), "copies keep their text");
+    }
+    expect(allocations == before, "building and copying exceptions does not allocate");
+
+    std::printf("%s\n", failures == 0 ? "all exception type checks passed" : "exception type checks failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+// InjectionDetector.h : Reusable SQL injection heuristics used by run_query.
+//
+// The detector is built once and shared by every query. check() tokenizes the SQL text
+// with SqlLexer.h and applies the SqlRules.h rules to the tokens, so a "--" or ';' inside a
+// string literal is not an injection and an OR operand that folds to true ("or 3>2",
+// "or name=name") is. The byte-level matchers it replaced are kept for comparison; they
+// give identical verdicts to each other but not to check():
+//   check_substring() - single pass over the raw SQL text, no regex, no copies
+//                       (vectorized by the InjectionPrefilter.h kernels where available)
+//   check_scalar()    - the same pass without the prefilter
+//   check_regex()     - the original lower/trim/find/regex rules, with the regexes compiled once
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include "InjectionPrefilter.h"
+#include "SqlRules.h"
+
+// Which heuristic (if any) rejected a query. Ordered by reporting priority.
+enum class InjectionVerdict
+{
+    Clean = 0,
+    MultipleStatements,
+    CommentToken,
+    Tautology,
+    UnbalancedQuotes
+};
+
+// Text used in the "Rejected query due to suspected SQL injection (...)" message.
+inline const char* describe(InjectionVerdict verdict)
+{
+    switch (verdict)
+    {
+    case InjectionVerdict::MultipleStatements: return "multiple statements detected";
+    case InjectionVerdict::CommentToken:       return "comment token detected";
+    case InjectionVerdict::Tautology:          return "tautology detected";
+    case InjectionVerdict::UnbalancedQuotes:   return "unbalanced quotes";
+    case InjectionVerdict::Clean:
+    default:                                   return "clean";
+    }
+}
+
+class InjectionDetector
+{
+public:
+    // Compiles the regex rules once; check() does not use them.
+    InjectionDetector()
+        : taut_num_(R"(\bor\s+\d+\s*=\s*\d+\b)", std::regex::optimize),
+          taut_str_(R"(\bor\s*'[^']*'\s*=\s*'[^']*')", std::regex::optimize)
+    {
+    }
+
+    // One lexer pass over the SQL text with every rule applied to the tokens as they come:
+    // 1) Multiple statements (any token after the first ';')
+    // 2) SQL comments ("--", "/* */") outside literals
+    // 3) OR operands that constant-fold to true
+    // 4) Strings or quoted identifiers without their closing quote
+    // No allocation; the tautology rule keeps the current OR operand in a fixed buffer.
+    InjectionVerdict check(std::string_view sql) const noexcept
+    {
+        return verdict(sql_rules::scan(sql));
+    }
+
+    // The verdict for a set of findings, in reporting priority.
+    static InjectionVerdict verdict(const sql_rules::Findings& findings) noexcept
+    {
+        if (findings.multiple_statements) return InjectionVerdict::MultipleStatements;
+        if (findings.comment) return InjectionVerdict::CommentToken;
+        if (findings.tautology) return InjectionVerdict::Tautology;
+        if (findings.unbalanced_quotes) return InjectionVerdict::UnbalancedQuotes;
+        return InjectionVerdict::Clean;
+    }
+
+    // Single pass over the SQL text that evaluates every rule together:
+    // 1) Multiple statements (a ';' before the end, ignoring trailing whitespace)
+    // 2) SQL comment tokens ("--", "/*")
+    // 3) OR tautologies: or <number>=<number>  or  or '<text>'='<text>'
+    // 4) Unbalanced single quotes
+    // Letters are case-folded on the fly, so no lowered copy is made. Where SSE2/AVX2 is
+    // available the text is scanned in blocks by the prefilter, and only the flagged
+    // bytes are examined further.
+    InjectionVerdict check_substring(std::string_view sql) const noexcept
+    {
+        ScanState state;
+        std::size_t i = 0;
+#if INJECTION_PREFILTER_WIDTH
+        // each block reads one byte past its end, so stop while a full block + 1 remains
+        for (; i + injection_prefilter::width < sql.size(); i += injection_prefilter::width)
+        {
+            const injection_prefilter::BlockMasks masks = injection_prefilter::scan_block(sql.data() + i);
+            if (masks.semicolon != 0 && state.first_semi == std::string_view::npos)
+            {
+                state.first_semi = i + static_cast<std::size_t>(injection_prefilter::lowest_bit(masks.semicolon));
+            }
+            state.quotes += static_cast<std::size_t>(injection_prefilter::popcount(masks.quote));
+            state.comment = state.comment || masks.comment != 0;
+            for (std::uint32_t bits = masks.or_token; bits != 0 && !state.tautology; bits &= bits - 1)
+            {
+                note_or_token(sql, i + static_cast<std::size_t>(injection_prefilter::lowest_bit(bits)), state);
+            }
+        }
+#endif
+        scan_scalar(sql, i, state);
+        return verdict(sql, state);
+    }
+
+    // The same rules without the prefilter, one byte at a time.
+    InjectionVerdict check_scalar(std::string_view sql) const noexcept
+    {
+        ScanState state;
+        scan_scalar(sql, 0, state);
+        return verdict(sql, state);
+    }
+
+    // Reference implementation of the same rules: lower, trim, then find/count/regex_search.
+    // Kept for cross-checking check_substring(); it scans the text several times.
+    InjectionVerdict check_regex(const std::string& sql) const
+    {
+        std::string trimmed = sql;
+        std::transform(trimmed.begin(), trimmed.end(), trimmed.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        while (!trimmed.empty() && is_trim_space(trimmed.back())) trimmed.pop_back();
+
+        std::size_t first_semi = trimmed.find(';');
+        if (first_semi != std::string::npos && first_semi != trimmed.size() - 1) return InjectionVerdict::MultipleStatements;
+
+        if (trimmed.find("--") != std::string::npos || trimmed.find("/*") != std::string::npos) return InjectionVerdict::CommentToken;
+
+        if (std::regex_search(trimmed, taut_num_) || std::regex_search(trimmed, taut_str_)) return InjectionVerdict::Tautology;
+
+        if (std::count(trimmed.begin(), trimmed.end(), '\'') % 2 != 0) return InjectionVerdict::UnbalancedQuotes;
+
+        return InjectionVerdict::Clean;
+    }
+
+private:
+    struct ScanState
+    {
+        std::size_t first_semi = std::string_view::npos;
+        std::size_t quotes = 0;
+        bool comment = false;
+        bool tautology = false;
+    };
+
+    // Scalar scan of sql[from..], folding into state.
+    static void scan_scalar(std::string_view sql, std::size_t from, ScanState& state) noexcept
+    {
+        const std::size_t n = sql.size();
+        for (std::size_t i = from; i < n; ++i)
+        {
+            switch (sql[i])
+            {
+            case ';':
+                if (state.first_semi == std::string_view::npos) state.first_semi = i;
+                break;
+            case '-':
+                if (i + 1 < n && sql[i + 1] == '-') state.comment = true;
+                break;
+            case '/':
+                if (i + 1 < n && sql[i + 1] == '*') state.comment = true;
+                break;
+            case '\'':
+                ++state.quotes;
+                break;
+            case 'o':
+            case 'O':
+                if (!state.tautology && i + 1 < n && to_lower(sql[i + 1]) == 'r') note_or_token(sql, i, state);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    // An "or" starts at i: it counts when it begins a word and a tautology follows.
+    static void note_or_token(std::string_view sql, std::size_t i, ScanState& state) noexcept
+    {
+        if (i == 0 || !is_word(sql[i - 1]))
+        {
+            state.tautology = matches_tautology(sql, i + 2);
+        }
+    }
+
+    static InjectionVerdict verdict(std::string_view sql, const ScanState& state) noexcept
+    {
+        // a ';' is only allowed as the last character that trim_right would keep
+        std::size_t end = sql.size();
+        while (end > 0 && is_trim_space(sql[end - 1])) --end;
+
+        if (state.first_semi != std::string_view::npos && state.first_semi + 1 != end) return InjectionVerdict::MultipleStatements;
+        if (state.comment) return InjectionVerdict::CommentToken;
+        if (state.tautology) return InjectionVerdict::Tautology;
+        if (state.quotes % 2 != 0) return InjectionVerdict::UnbalancedQuotes;
+        return InjectionVerdict::Clean;
+    }
+
+    static bool is_trim_space(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static bool is_regex_space(char c) noexcept { return is_trim_space(c) || c == '\v' || c == '\f'; }
+    static bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+    static char to_lower(char c) noexcept { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+    static bool is_word(char c) noexcept { return is_digit(c) || c == '_' || (to_lower(c) >= 'a' && to_lower(c) <= 'z'); }
+
+    // Matches what follows an "or" token against both tautology shapes, starting at pos.
+    static bool matches_tautology(std::string_view s, std::size_t pos) noexcept
+    {
+        const std::size_t n = s.size();
+
+        // \s+ \d+ \s* = \s* \d+ \b
+        std::size_t k = pos;
+        while (k < n && is_regex_space(s[k])) ++k;
+        if (k > pos)
+        {
+            std::size_t j = k;
+            while (j < n && is_digit(s[j])) ++j;
+            if (j > k)
+            {
+                while (j < n && is_regex_space(s[j])) ++j;
+                if (j < n && s[j] == '=')
+                {
+                    ++j;
+                    while (j < n && is_regex_space(s[j])) ++j;
+                    const std::size_t digits = j;
+                    while (j < n && is_digit(s[j])) ++j;
+                    if (j > digits && (j == n || !is_word(s[j]))) return true;
+                }
+            }
+        }
+
+        // \s* '[^']*' \s* = \s* '[^']*'
+        if (k < n && s[k] == '\'')
+        {
+            std::size_t j = s.find('\'', k + 1);
+            if (j == std::string_view::npos) return false;
+            ++j;
+            while (j < n && is_regex_space(s[j])) ++j;
+            if (j < n && s[j] == '=')
+            {
+                ++j;
+                while (j < n && is_regex_space(s[j])) ++j;
+                if (j < n && s[j] == '\'' && s.find('\'', j + 1) != std::string_view::npos) return true;
+            }
+        }
+        return false;
+    }
+
+    std::regex taut_num_;
+    std::regex taut_str_;
+};
+
+// The process-wide detector. Construction is thread-safe and happens on first use.
+inline const InjectionDetector& shared_injection_detector()
+{
+    static const InjectionDetector detector;
+    return detector;
+}
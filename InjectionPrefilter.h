@@ -0,0 +1,116 @@
+// InjectionPrefilter.h : Vectorized pre-filter for the injection heuristics.
+//
+// Instead of lowering the SQL text and then searching it once per rule, one pass
+// over W-byte blocks (AVX2: 32, SSE2: 16) builds a bitmask per special token:
+//   semicolon  ';'
+//   quote      '\''
+//   comment    "--" or "/*"  (a byte whose successor completes the pair)
+//   or_token   "or" in any case, folded in-register by OR-ing 0x20
+// The detector then only looks at the flagged positions; the tautology rules run
+// only around "or" tokens. Targets without SSE2 fall back to the scalar matcher.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define INJECTION_PREFILTER_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INJECTION_PREFILTER_WIDTH 16
+#else
+#define INJECTION_PREFILTER_WIDTH 0
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace injection_prefilter
+{
+    // Bytes handled per block; 0 when only the scalar path is available.
+    constexpr std::size_t width = INJECTION_PREFILTER_WIDTH;
+
+    // Bit i is set when byte i of the block starts the token.
+    struct BlockMasks
+    {
+        std::uint32_t semicolon;
+        std::uint32_t quote;
+        std::uint32_t comment;
+        std::uint32_t or_token;
+    };
+
+    inline int popcount(std::uint32_t bits)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return static_cast<int>(__popcnt(bits));
+#else
+        return __builtin_popcount(bits);
+#endif
+    }
+
+    // Index of the lowest set bit; bits must not be 0.
+    inline int lowest_bit(std::uint32_t bits)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(bits);
+#endif
+    }
+
+#if INJECTION_PREFILTER_WIDTH == 32
+    // Reads width + 1 bytes starting at p (the extra byte completes two-byte tokens).
+    inline BlockMasks scan_block(const char* p)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        const __m256i case_bit = _mm256_set1_epi8(0x20);
+        const __m256i folded = _mm256_or_si256(v, case_bit);
+        const __m256i folded_next = _mm256_or_si256(next, case_bit);
+
+        const __m256i dash_dash = _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')),
+            _mm256_cmpeq_epi8(next, _mm256_set1_epi8('-')));
+        const __m256i slash_star = _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')),
+            _mm256_cmpeq_epi8(next, _mm256_set1_epi8('*')));
+        const __m256i o_r = _mm256_and_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('o')),
+            _mm256_cmpeq_epi8(folded_next, _mm256_set1_epi8('r')));
+
+        BlockMasks masks;
+        masks.semicolon = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(';'))));
+        masks.quote = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''))));
+        masks.comment = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(dash_dash, slash_star)));
+        masks.or_token = static_cast<std::uint32_t>(_mm256_movemask_epi8(o_r));
+        return masks;
+    }
+#elif INJECTION_PREFILTER_WIDTH == 16
+    // Reads width + 1 bytes starting at p (the extra byte completes two-byte tokens).
+    inline BlockMasks scan_block(const char* p)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        const __m128i folded = _mm_or_si128(v, case_bit);
+        const __m128i folded_next = _mm_or_si128(next, case_bit);
+
+        const __m128i dash_dash = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')),
+            _mm_cmpeq_epi8(next, _mm_set1_epi8('-')));
+        const __m128i slash_star = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+            _mm_cmpeq_epi8(next, _mm_set1_epi8('*')));
+        const __m128i o_r = _mm_and_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('o')),
+            _mm_cmpeq_epi8(folded_next, _mm_set1_epi8('r')));
+
+        BlockMasks masks;
+        masks.semicolon = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(';'))));
+        masks.quote = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\''))));
+        masks.comment = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(dash_dash, slash_star)));
+        masks.or_token = static_cast<std::uint32_t>(_mm_movemask_epi8(o_r));
+        return masks;
+    }
+#endif
+}
@@ -0,0 +1,214 @@
+// InputReader.h : Buffered, allocation-free reader for the Project One menu input.
+//
+// std::cin >> x goes through the locale, the stream state, and (while cin is tied and
+// synced with stdio) a flush of std::cout before every read. InputReader instead pulls
+// whatever is available with one read() on the file descriptor into a fixed buffer and
+// hands out tokens and lines as string_views into it; integers are parsed with
+// std::from_chars. When it runs out of buffered input it flushes std::cout (or the stream
+// given to flush_before_read) first, so a prompt is always visible before the program
+// waits, while piped scripts get their output in large blocks.
+//
+// unsync_stdio() turns off the per-character stdio synchronization and cin/cout tying;
+// call it once at start-up, and afterwards write prompts with '\n' rather than std::endl.
+//
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+// Makes iostreams independent of stdio and stops cin from flushing cout on every read.
+inline void unsync_stdio()
+{
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+}
+
+class InputReader
+{
+public:
+    enum class Status { Ok, Invalid, End };
+
+    // Reads from fd (0 = standard input). Tokens and lines are limited to capacity bytes;
+    // anything longer is handed out in capacity-sized pieces.
+    explicit InputReader(int fd = 0, std::size_t capacity = 64 * 1024)
+        : fd_(fd), buffer_(capacity != 0 ? capacity : 1)
+    {
+    }
+
+    ~InputReader()
+    {
+        close_owned();
+    }
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // Switches to reading the file at path (closed again by the reader). Returns false,
+    // leaving the reader at end of input, when it cannot be opened.
+    bool open_file(const std::string& path)
+    {
+        close_owned();
+#if defined(_WIN32)
+        fd_ = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+#endif
+        owns_fd_ = fd_ >= 0;
+        begin_ = end_ = 0;
+        eof_ = fd_ < 0;
+        return owns_fd_;
+    }
+
+    // The stream flushed before each read() of new input; NULL flushes nothing.
+    void flush_before_read(std::ostream* out) { flush_ = out; }
+
+    // The next whitespace-delimited token, like std::cin >> std::string. The view is valid
+    // until the next call. Returns false at end of input.
+    bool next_token(std::string_view& token)
+    {
+        for (;;)
+        {
+            while (begin_ < end_ && is_space(buffer_[begin_])) ++begin_;
+            if (begin_ < end_) break;
+            if (!fill()) return false;
+        }
+
+        std::size_t i = begin_;
+        for (;;)
+        {
+            while (i < end_ && !is_space(buffer_[i])) ++i;
+            if (i < end_ || eof_ || end_ - begin_ == buffer_.size()) break;   // ended, or fills the buffer
+            const std::size_t scanned = i - begin_;
+            if (!fill()) break;
+            i = begin_ + scanned;
+        }
+
+        token = std::string_view(buffer_.data() + begin_, i - begin_);
+        begin_ = i;
+        return true;
+    }
+
+    // The rest of the current line without its '\n' (or "\r\n"). Returns false at end of input.
+    bool next_line(std::string_view& line)
+    {
+        if (begin_ == end_ && !fill()) return false;
+
+        std::size_t i = begin_;
+        bool found = false;
+        for (;;)
+        {
+            const char* nl = static_cast<const char*>(std::memchr(buffer_.data() + i, '\n', end_ - i));
+            if (nl != nullptr)
+            {
+                i = static_cast<std::size_t>(nl - buffer_.data());
+                found = true;
+                break;
+            }
+            i = end_;
+            if (eof_ || end_ - begin_ == buffer_.size()) break;
+            const std::size_t scanned = i - begin_;
+            if (!fill()) break;
+            i = begin_ + scanned;
+        }
+
+        std::size_t length = i - begin_;
+        if (length > 0 && buffer_[begin_ + length - 1] == '\r') --length;
+        line = std::string_view(buffer_.data() + begin_, length);
+        begin_ = found ? i + 1 : i;
+        return true;
+    }
+
+    // Reads the next token as a decimal int. Invalid when the token is not entirely a
+    // number in int's range (the token is consumed either way).
+    Status next_int(int& value)
+    {
+        std::string_view token;
+        if (!next_token(token)) return Status::End;
+        const char* first = token.data();
+        const char* last = token.data() + token.size();
+        if (first != last && *first == '+') ++first;   // accepted by operator>>
+        const std::from_chars_result parsed = std::from_chars(first, last, value);
+        return (parsed.ec == std::errc() && parsed.ptr == last) ? Status::Ok : Status::Invalid;
+    }
+
+    // Discards the rest of the current line, like cin.ignore(max, '\n').
+    void skip_line()
+    {
+        std::string_view ignored;
+        next_line(ignored);
+    }
+
+    bool eof() const { return eof_ && begin_ == end_; }
+
+private:
+    void close_owned()
+    {
+        if (!owns_fd_) return;
+#if defined(_WIN32)
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+        owns_fd_ = false;
+    }
+
+    static bool is_space(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Moves unread bytes to the front and appends one read()'s worth of input. Returns false
+    // when nothing was added (end of input, an error, or a full buffer).
+    bool fill()
+    {
+        if (eof_) return false;
+        if (begin_ > 0)
+        {
+            std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (end_ == buffer_.size()) return false;
+
+        if (flush_) flush_->flush();   // show any pending prompt before waiting for input
+        for (;;)
+        {
+#if defined(_WIN32)
+            const int n = _read(fd_, buffer_.data() + end_, static_cast<unsigned int>(buffer_.size() - end_));
+#else
+            const ssize_t n = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+            if (n < 0 && errno == EINTR) continue;
+#endif
+            if (n <= 0)
+            {
+                eof_ = true;
+                return false;
+            }
+            end_ += static_cast<std::size_t>(n);
+            return true;
+        }
+    }
+
+    int fd_;
+    bool owns_fd_ = false;
+    std::ostream* flush_ = &std::cout;
+    std::vector<char> buffer_;
+    std::size_t begin_ = 0;   // first unread byte
+    std::size_t end_ = 0;     // one past the last buffered byte
+    bool eof_ = false;
+};
@@ -0,0 +1,205 @@
+// LoginLimiter.h : Lock-free per-user login failure limiting for Project One.
+//
+// Every username has a token bucket of `burst` tokens that refills at one token per
+// refill_interval. A failed login spends a token; a user whose bucket is empty is locked
+// out until it refills, and allow() says so before the password is hashed, so a flood of
+// guesses against locked accounts costs a table probe each rather than a hash. A successful
+// login refills the bucket.
+//
+// The buckets live in a fixed table split into shards of one-cache-line-aligned slots,
+// picked by the username hash. A slot is two atomics: the 64-bit hash of the username and
+// the bucket, packed as (milliseconds since the limiter started, tokens in 1/1024ths) so
+// it is read and replaced with a single compare-exchange. Nothing takes a lock, and
+// sessions logging in as different users touch different cache lines. A user with a full
+// bucket needs no slot, so a full slot can be taken over by another user; when every slot
+// a user may probe is held by a draining bucket, the user shares the shard's spare bucket.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+class LoginLimiter
+{
+public:
+    struct Options
+    {
+        std::uint32_t burst = 5;                              // failures allowed back-to-back
+        std::chrono::milliseconds refill_interval{ 30000 };   // time to earn one more attempt
+        std::size_t shards = 64;                              // rounded up to a power of two
+        std::size_t slots_per_shard = 64;                     // rounded up to a power of two
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    LoginLimiter() : LoginLimiter(Options()) {}
+
+    explicit LoginLimiter(Options options)
+        : burst_(std::min<std::uint64_t>(std::max<std::uint32_t>(options.burst, 1u), max_tokens))
+        , refill_ms_(static_cast<std::uint64_t>(std::max<std::chrono::milliseconds::rep>(options.refill_interval.count(), 1)))
+        , shard_mask_(round_up(options.shards) - 1)
+        , slot_mask_(round_up(options.slots_per_shard) - 1)
+        , slots_(new Slot[(shard_mask_ + 1) * (slot_mask_ + 1)])
+        , spare_(new Slot[shard_mask_ + 1])
+        , start_(clock::now())
+    {
+        // Unused slots hold a full bucket, so claiming one never has to reset it.
+        const std::uint64_t full = pack(0, burst_ * unit);
+        for (std::size_t i = 0; i < (shard_mask_ + 1) * (slot_mask_ + 1); ++i) slots_[i].bucket.store(full, std::memory_order_relaxed);
+        for (std::size_t i = 0; i <= shard_mask_; ++i) spare_[i].bucket.store(full, std::memory_order_relaxed);
+    }
+
+    LoginLimiter(const LoginLimiter&) = delete;
+    LoginLimiter& operator=(const LoginLimiter&) = delete;
+
+    // False while username is locked out; check before verifying the password.
+    bool allow(std::string_view username, clock::time_point now = clock::now()) const
+    {
+        const std::uint64_t key = hash(username);
+        const Slot* slot = find(key);
+        if (slot == nullptr) return true;
+        return tokens(slot->bucket.load(std::memory_order_acquire), elapsed_ms(now)) >= unit;
+    }
+
+    // Spends one of username's attempts.
+    void record_failure(std::string_view username, clock::time_point now = clock::now())
+    {
+        const std::uint64_t key = hash(username);
+        const std::uint64_t at = elapsed_ms(now);
+        Slot& slot = claim(key, at);
+        std::uint64_t bucket = slot.bucket.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            const std::uint64_t left = tokens(bucket, at);
+            const std::uint64_t next = pack(at, left >= unit ? left - unit : 0);
+            if (slot.bucket.compare_exchange_weak(bucket, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    // Gives username its full set of attempts back.
+    void record_success(std::string_view username, clock::time_point now = clock::now())
+    {
+        Slot* slot = find(hash(username));
+        if (slot != nullptr) slot->bucket.store(pack(elapsed_ms(now), burst_ * unit), std::memory_order_release);
+    }
+
+    // Time until username may try again (zero when it may now).
+    std::chrono::milliseconds retry_after(std::string_view username, clock::time_point now = clock::now()) const
+    {
+        const Slot* slot = find(hash(username));
+        if (slot == nullptr) return std::chrono::milliseconds(0);
+        const std::uint64_t left = tokens(slot->bucket.load(std::memory_order_acquire), elapsed_ms(now));
+        if (left >= unit) return std::chrono::milliseconds(0);
+        return std::chrono::milliseconds(((unit - left) * refill_ms_ + unit - 1) / unit);
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint64_t> key{ 0 };      // 0 = never used
+        std::atomic<std::uint64_t> bucket{ 0 };   // pack(time, tokens)
+    };
+
+    static constexpr std::uint64_t unit = 1024;                 // one token
+    static constexpr int token_bits = 24;
+    static constexpr std::uint64_t token_mask = (std::uint64_t(1) << token_bits) - 1;
+    static constexpr std::uint64_t max_tokens = token_mask / unit;
+    static constexpr std::size_t max_probe = 8;
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t p = 1;
+        while (p < n) p *= 2;
+        return p;
+    }
+
+    // FNV-1a, 64-bit; never 0, which marks an unused slot.
+    static std::uint64_t hash(std::string_view bytes)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (const unsigned char c : bytes)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h != 0 ? h : 1;
+    }
+
+    static std::uint64_t pack(std::uint64_t at_ms, std::uint64_t tokens) { return (at_ms << token_bits) | tokens; }
+
+    std::uint64_t elapsed_ms(clock::time_point now) const
+    {
+        if (now <= start_) return 0;
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count());
+    }
+
+    // A bucket's tokens (in units) at time at, refilled since it was last written.
+    std::uint64_t tokens(std::uint64_t bucket, std::uint64_t at) const
+    {
+        const std::uint64_t then = bucket >> token_bits;
+        const std::uint64_t left = bucket & token_mask;
+        const std::uint64_t refilled = at > then ? (at - then) * unit / refill_ms_ : 0;
+        return std::min(left + refilled, burst_ * unit);
+    }
+
+    Slot* shard(std::uint64_t key) const { return &slots_[((key >> 40) & shard_mask_) * (slot_mask_ + 1)]; }
+
+    Slot* find(std::uint64_t key) const
+    {
+        Slot* slots = shard(key);
+        for (std::size_t i = 0; i < max_probe && i <= slot_mask_; ++i)
+        {
+            Slot& slot = slots[(key + i) & slot_mask_];
+            const std::uint64_t held = slot.key.load(std::memory_order_acquire);
+            if (held == key) return &slot;
+            if (held == 0) return nullptr;
+        }
+        Slot& spare = spare_[(key >> 40) & shard_mask_];
+        return spare.key.load(std::memory_order_acquire) != 0 ? &spare : nullptr;
+    }
+
+    // The slot for key, taking an unused one or one whose bucket has refilled.
+    Slot& claim(std::uint64_t key, std::uint64_t at)
+    {
+        Slot* slots = shard(key);
+        for (std::size_t i = 0; i < max_probe && i <= slot_mask_; ++i)
+        {
+            Slot& slot = slots[(key + i) & slot_mask_];
+            std::uint64_t held = slot.key.load(std::memory_order_acquire);
+            if (held == key) return slot;
+            if (held == 0)
+            {
+                if (slot.key.compare_exchange_strong(held, key, std::memory_order_acq_rel)) return slot;
+                if (held == key) return slot;
+            }
+        }
+        // Take over a slot nobody needs any more: its bucket has refilled completely.
+        for (std::size_t i = 0; i < max_probe && i <= slot_mask_; ++i)
+        {
+            Slot& slot = slots[(key + i) & slot_mask_];
+            std::uint64_t bucket = slot.bucket.load(std::memory_order_acquire);
+            if (tokens(bucket, at) < burst_ * unit) continue;
+            if (!slot.bucket.compare_exchange_strong(bucket, pack(at, burst_ * unit), std::memory_order_acq_rel)) continue;
+            slot.key.store(key, std::memory_order_release);
+            return slot;
+        }
+        Slot& spare = spare_[(key >> 40) & shard_mask_];
+        spare.key.store(1, std::memory_order_release);
+        return spare;
+    }
+
+    const std::uint64_t burst_;
+    const std::uint64_t refill_ms_;
+    const std::size_t shard_mask_;
+    const std::size_t slot_mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<Slot[]> spare_;
+    const clock::time_point start_;
+};
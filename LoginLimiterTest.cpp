@@ -0,0 +1,75 @@
+// LoginLimiterTest.cpp : Checks of the per-user login lockout.
+//
+// Drives a LoginLimiter with explicit time points: a user is locked out after `burst`
+// failures, earns one attempt back per refill_interval, gets all of them back on a
+// successful login, and does not affect other users. A one-slot table checks that users
+// who cannot get a slot of their own stay locked out rather than being let through.
+// Exits non-zero on the first failure. Run by ctest (test login_limiter).
+//
+
+#include <chrono>
+#include <cstdio>
+
+#include "LoginLimiter.h"
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++failures;
+        }
+    }
+
+    using std::chrono::milliseconds;
+}
+
+int main()
+{
+    LoginLimiter::Options options;
+    options.burst = 3;
+    options.refill_interval = milliseconds(1000);
+    LoginLimiter limiter(options);
+    const LoginLimiter::clock::time_point t0 = LoginLimiter::clock::now();
+
+    expect(limiter.allow("alice", t0), "a new user may log in");
+    for (int i = 0; i < 3; ++i)
+    {
+        expect(limiter.allow("alice", t0), "attempts left before the burst is spent");
+        limiter.record_failure("alice", t0);
+    }
+    expect(!limiter.allow("alice", t0), "locked out after burst failures");
+    expect(limiter.retry_after("alice", t0) == milliseconds(1000), "retry after one refill interval");
+    expect(limiter.allow("bob", t0), "another user is not locked out");
+
+    expect(!limiter.allow("alice", t0 + milliseconds(999)), "still locked just before the refill");
+    expect(limiter.allow("alice", t0 + milliseconds(1000)), "one attempt back after the refill");
+    limiter.record_failure("alice", t0 + milliseconds(1000));
+    expect(!limiter.allow("alice", t0 + milliseconds(1000)), "the refilled attempt is spent");
+
+    limiter.record_success("alice", t0 + milliseconds(1000));
+    expect(limiter.retry_after("alice", t0 + milliseconds(1000)) == milliseconds(0), "a success ends the lockout");
+    for (int i = 0; i < 3; ++i) limiter.record_failure("alice", t0 + milliseconds(1000));
+    expect(!limiter.allow("alice", t0 + milliseconds(1000)), "a success gives back the whole burst, no more");
+
+    LoginLimiter::Options tiny = options;
+    tiny.shards = 1;
+    tiny.slots_per_shard = 1;
+    LoginLimiter crowded(tiny);
+    const char* const users[] = { "u1", "u2", "u3", "u4" };
+    for (const char* user : users)
+    {
+        for (int i = 0; i < 3; ++i) crowded.record_failure(user, t0);
+    }
+    for (const char* user : users)
+    {
+        expect(!crowded.allow(user, t0), "users beyond the table's slots stay locked out");
+    }
+
+    std::printf("%s\n", failures == 0 ? "all login limiter checks passed" : "login limiter checks failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -1,161 +1,42 @@
 // NumericOverflows.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
 
+#include <algorithm>      // std::min
+#include <atomic>         // std::atomic (benchmark task counter)
+#include <chrono>         // std::chrono::steady_clock (benchmark timing)
+#include <fstream>        // std::ofstream (benchmark report)
 #include <iostream>       // std::cout
 #include <limits>         // std::numeric_limits
-#include <type_traits>    // std::is_integral_v, std::is_floating_point_v, std::is_signed_v
+#include <sstream>        // std::ostringstream, std::istringstream (benchmark report/options)
+#include <string>         // std::string
+#include <thread>         // std::thread (benchmark workers)
+#include <type_traits>    // std::is_integral_v, std::is_floating_point_v, std::is_signed_v, std::make_unsigned_t
 #include <typeinfo>       // typeid
+#include <cfenv>          // std::feclearexcept, std::fetestexcept (sticky overflow flags)
 #include <cmath>          // std::isfinite, std::isnormal
+#include <cstddef>        // std::size_t
+#include <cstdint>        // std::uint64_t
+#include <span>           // std::span (batch APIs, C++20)
+#include <vector>         // std::vector (batch tests)
 
-// A small return type to communicate both the numeric value and whether the operation was safe.
-// ok == true means no overflow or underflow occurred.
-// ok == false means we detected an impending overflow/underflow and stopped before it happened.
-// value is the last safe value we could compute.
-template <typename T>
-struct Checked {
-    T value{};
-    bool ok{ true };
-};
-
-/*
-    Helper: check if a + b would overflow or underflow for integral T.
-    This uses classic "add will overflow if a > max - b" style rules.
-*/
-template <typename T>
-inline bool will_add_overflow_integral(T a, T b) {
-    static_assert(std::is_integral_v<T>, "integral only");
-    using Lim = std::numeric_limits<T>;
-    if constexpr (std::is_signed_v<T>) {
-        if (b > 0 && a > Lim::max() - b) return true;
-        if (b < 0 && a < Lim::min() - b) return true;
-        return false;
-    }
-    else {
-        // unsigned
-        return a > Lim::max() - b; // b cannot be negative for unsigned
-    }
-}
+#include "CheckedArithmetic.h"   // Checked<T>, add_numbers / subtract_numbers, batch APIs
+#include "CheckedInt.h"          // checked::checked_int (compile-time overflow matrix)
+#include "EventLog.h"            // EVENT_INFO (ok=false results of the overflow tests)
 
-/*
-    Helper: check if a - b would overflow or underflow for integral T.
-    Implemented via addition check by negating b when signed.
-*/
-template <typename T>
-inline bool will_sub_overflow_integral(T a, T b) {
-    static_assert(std::is_integral_v<T>, "integral only");
-    if constexpr (std::is_signed_v<T>) {
-        return will_add_overflow_integral<T>(a, static_cast<T>(-b));
-    }
-    else {
-        // For unsigned, a - b underflows if b > a
-        return b > a;
-    }
-}
-
-/*
-    Helper: for floating point we treat overflow if the next value is not finite
-    or its magnitude exceeds the type's max. Tiny subnormal values are allowed;
-    if you want to treat loss of normal as underflow, we mark ok=false but still
-    provide the computed value (which may be 0 due to flush-to-zero on some targets).
-*/
-template <typename T>
-inline bool add_would_overflow_floating(T a, T b) {
-    static_assert(std::is_floating_point_v<T>, "floating only");
-    long double trial = static_cast<long double>(a) + static_cast<long double>(b);
-    if (!std::isfinite(trial)) return true;
-    long double m = static_cast<long double>(std::numeric_limits<T>::max());
-    return std::fabsl(trial) > m;
-}
-
-template <typename T>
-inline bool sub_would_overflow_floating(T a, T b) {
-    static_assert(std::is_floating_point_v<T>, "floating only");
-    long double trial = static_cast<long double>(a) - static_cast<long double>(b);
-    if (!std::isfinite(trial)) return true;
-    long double m = static_cast<long double>(std::numeric_limits<T>::max());
-    return std::fabsl(trial) > m;
-}
-
-/// <summary>
-/// Template function to compute: start + (increment * steps)
-/// Now returns Checked<T> so callers know if an overflow would have occurred.
-/// We prevent overflow by stopping before the unsafe step and setting ok=false.
-/// </summary>
-template <typename T>
-Checked<T> add_numbers(T const& start, T const& increment, unsigned long int const& steps)
-{
-    Checked<T> out{ start, true };
-
-    // Iterate step by step so we can preflight each addition regardless of type.
-    for (unsigned long int i = 0; i < steps; ++i)
-    {
-        // Integral path: use bounds checks
-        if constexpr (std::is_integral_v<T>) {
-            if (will_add_overflow_integral<T>(out.value, increment)) {
-                out.ok = false;            // signal overflow would have happened
-                break;                     // prevent it
-            }
-            out.value = static_cast<T>(out.value + increment);
-        }
-        // Floating path: check finiteness and max magnitude
-        else if constexpr (std::is_floating_point_v<T>) {
-            if (add_would_overflow_floating<T>(out.value, increment)) {
-                out.ok = false;
-                break;
-            }
-            T next = static_cast<T>(out.value + increment);
-            // Optional: treat loss of normal as underflow warning
-            if (!std::isfinite(next)) { out.ok = false; break; }
-            out.value = next;
-        }
-        else {
-            // For unexpected numeric-like types, do a conservative attempt
-            out.value = static_cast<T>(out.value + increment);
-        }
-    }
-
-    return out;
-}
+//  NOTE:
+//    You will see the unary ('+') operator used in front of the variables in the test_XXX methods.
+//    This forces the output to be a number for cases where cout would assume it is a character. 
 
-/// <summary>
-/// Template function to compute: start - (decrement * steps)
-/// Returns Checked<T> to communicate safety. Prevents underflow/overflow.
-/// </summary>
+// Records a result that stopped short of an overflow or underflow (ok == false) as an event.
 template <typename T>
-Checked<T> subtract_numbers(T const& start, T const& decrement, unsigned long int const& steps)
+void log_unsafe_result(const char* operation, T start, T step, unsigned long int steps, const Checked<T>& result)
 {
-    Checked<T> out{ start, true };
-
-    for (unsigned long int i = 0; i < steps; ++i)
-    {
-        if constexpr (std::is_integral_v<T>) {
-            if (will_sub_overflow_integral<T>(out.value, decrement)) {
-                out.ok = false;            // signal underflow or overflow would occur
-                break;                     // prevent it
-            }
-            out.value = static_cast<T>(out.value - decrement);
-        }
-        else if constexpr (std::is_floating_point_v<T>) {
-            if (sub_would_overflow_floating<T>(out.value, decrement)) {
-                out.ok = false;
-                break;
-            }
-            T next = static_cast<T>(out.value - decrement);
-            if (!std::isfinite(next)) { out.ok = false; break; }
-            out.value = next;
-        }
-        else {
-            out.value = static_cast<T>(out.value - decrement);
-        }
-    }
-
-    return out;
+    if (result.ok) return;
+    EVENT_INFO("overflow_prevented", event_log::field("operation", operation),
+        event_log::field("type", typeid(T).name()), event_log::field("start", +start),
+        event_log::field("step", +step), event_log::field("steps", steps), event_log::field("result", +result.value));
 }
 
-//  NOTE:
-//    You will see the unary ('+') operator used in front of the variables in the test_XXX methods.
-//    This forces the output to be a number for cases where cout would assume it is a character. 
-
 template <typename T>
 void test_overflow()
 {
@@ -169,10 +50,12 @@ void test_overflow()
 
     std::cout << "\tAdding Numbers Without Overflow (" << +start << ", " << +increment << ", " << steps << ") => ";
     auto r1 = add_numbers<T>(start, increment, steps);
+    log_unsafe_result("add", start, increment, steps, r1);
     std::cout << "ok=" << std::boolalpha << r1.ok << ", result=" << +r1.value << std::endl;
 
     std::cout << "\tAdding Numbers With Overflow (" << +start << ", " << +increment << ", " << (steps + 1) << ") => ";
     auto r2 = add_numbers<T>(start, increment, steps + 1);
+    log_unsafe_result("add", start, increment, steps + 1, r2);
     std::cout << "ok=" << std::boolalpha << r2.ok << ", result=" << +r2.value << std::endl;
 }
 
@@ -189,10 +72,12 @@ void test_underflow()
 
     std::cout << "\tSubtracting Numbers Without Overflow (" << +start << ", " << +decrement << ", " << steps << ") => ";
     auto r1 = subtract_numbers<T>(start, decrement, steps);
+    log_unsafe_result("subtract", start, decrement, steps, r1);
     std::cout << "ok=" << std::boolalpha << r1.ok << ", result=" << +r1.value << std::endl;
 
     std::cout << "\tSubtracting Numbers With Overflow (" << +start << ", " << +decrement << ", " << (steps + 1) << ") => ";
     auto r2 = subtract_numbers<T>(start, decrement, steps + 1);
+    log_unsafe_result("subtract", start, decrement, steps + 1, r2);
     std::cout << "ok=" << std::boolalpha << r2.ok << ", result=" << +r2.value << std::endl;
 }
 
@@ -250,18 +135,403 @@ void do_underflow_tests(const std::string& star_line)
     test_underflow<long double>();
 }
 
+// The overflow / underflow matrix above, evaluated by the compiler with checked_int.
+// Floating types stay runtime-only: a constant expression may not overflow to infinity.
+template <typename T>
+constexpr bool overflow_matrix_holds()
+{
+    const unsigned long int steps = 5;
+    const T increment = std::numeric_limits<T>::max() / steps;
+    const T start = 0;
+
+    const auto r1 = checked::add_steps<T>(start, increment, steps);
+    const auto r2 = checked::add_steps<T>(start, increment, steps + 1);
+    return r1.ok() && r1.value() == static_cast<T>(increment * static_cast<T>(steps))
+        && !r2.ok() && r2.value() == r1.value();
+}
+
+template <typename T>
+constexpr bool underflow_matrix_holds()
+{
+    const unsigned long int steps = 5;
+    const T decrement = std::numeric_limits<T>::max() / steps;
+    const T start = std::numeric_limits<T>::max();
+
+    const auto r1 = checked::subtract_steps<T>(start, decrement, steps);
+    const auto r2 = checked::subtract_steps<T>(start, decrement, steps + 1);
+    // signed types have room below zero, so the sixth step still fits
+    const bool r2_fits = std::is_signed_v<T>;
+    const T after_steps = static_cast<T>(start - decrement * static_cast<T>(steps));
+    return r1.ok() && r1.value() == after_steps
+        && r2.ok() == r2_fits
+        && r2.value() == (r2_fits ? static_cast<T>(after_steps - decrement) : r1.value());
+}
+
+template <typename... Ts>
+constexpr bool matrix_holds_for()
+{
+    return (... && (overflow_matrix_holds<Ts>() && underflow_matrix_holds<Ts>()));
+}
+
+static_assert(matrix_holds_for<char, wchar_t, short int, int, long, long long>(), "signed overflow matrix");
+static_assert(matrix_holds_for<unsigned char, unsigned short int, unsigned int, unsigned long, unsigned long long>(),
+    "unsigned overflow matrix");
+
+// The other policies at the edge of the range.
+static_assert((checked::checked_int<int, checked::saturate>(std::numeric_limits<int>::max()) + 1).value()
+    == std::numeric_limits<int>::max(), "saturate clamps");
+static_assert((checked::checked_int<unsigned char, checked::saturate>(3) - 4).value() == 0, "saturate clamps");
+static_assert((checked::checked_int<unsigned char, checked::wrap>(255) + 1).value() == 0, "wrap wraps");
+static_assert((checked::checked_int<int, checked::trap>(1 << 20) * 1024).value() == 1 << 30, "trap passes safe values");
+
+template <typename T>
+void test_batch()
+{
+    // 1000 counters of max/500: each pair adds safely, the 501st partial sum overflows
+    const std::size_t count = 1000;
+    const T increment = std::numeric_limits<T>::max() / 500;
+    std::vector<T> a(count, increment), b(count, increment), out(count);
+    a[7] = std::numeric_limits<T>::max();   // the only element pair that overflows
+    std::vector<std::uint64_t> bits((count + 63) / 64);
+
+    std::cout << "Batch Test of Type = " << typeid(T).name() << std::endl;
+
+    auto r1 = checked_add<T>(a, b, out, bits);
+    std::cout << "\tchecked_add of " << count << " pairs => ok=" << std::boolalpha << r1.ok()
+        << ", overflows=" << r1.count << ", first index=" << r1.first_index << ", kept=" << +out[7] << std::endl;
+
+    auto r2 = checked_sum<T>(std::span<const T>(b));
+    std::cout << "\tchecked_sum of " << count << " x " << +increment << " => ok=" << std::boolalpha << r2.ok
+        << ", result=" << +r2.value << ", failed index=" << r2.failed_index << std::endl;
+
+    if constexpr (std::is_floating_point_v<T>) {
+        auto r3 = checked_sum_sticky<T>(std::span<const T>(b));
+        std::cout << "\tchecked_sum_sticky of " << count << " x " << +increment << " => ok=" << std::boolalpha << r3.ok
+            << ", result=" << +r3.value << ", failed index=" << r3.failed_index << std::endl;
+    }
+}
+
+void do_batch_tests(const std::string& star_line)
+{
+    std::cout << std::endl << star_line << std::endl;
+    std::cout << "*** Running Batch Checked Arithmetic Tests ***" << std::endl;
+    std::cout << star_line << std::endl;
+
+    test_batch<int>();
+    test_batch<unsigned short int>();
+    test_batch<long long>();
+    test_batch<double>();
+}
+
+/*
+    Benchmark harness (run with --bench).
+
+    Times every add_numbers/subtract_numbers variant for each type of the test matrix:
+      loop         add_numbers_loop / subtract_numbers_loop, one checked step at a time
+      closed_form  add_numbers_closed_form / subtract_numbers_closed_form (integral only)
+      simd         checked_sum over blocks of the increment (vectorized for integral
+                   types); subtracting is summing -decrement, so unsigned types have none
+    The matrix is a compile-time type list; each type is one task, and the tasks are
+    spread across worker threads. Each measurement starts at 0 (add) or max (subtract)
+    and steps by max / steps, so every variant does the full number of steps unless the
+    step rounds to zero and has to be 1 (steps_per_second always counts the requested
+    steps). Results go out as JSON or CSV, in the order of the type list, whatever
+    thread ran them; the JSON report also names the compiler, so runs can be compared
+    across toolchains.
+
+    Options:
+      --steps=5,1000,1000000   step counts to time
+      --threads=N              worker threads (default: hardware concurrency); use 1 for
+                               the least noisy numbers
+      --min-time-ms=N          minimum time per measurement (default 20)
+      --format=json|csv        report format (default json)
+      --out=PATH               write the report to PATH instead of stdout
+*/
+template <typename... Ts>
+struct type_list {};
+
+using matrix_types = type_list<char, wchar_t, short int, int, long, long long,
+    unsigned char, unsigned short int, unsigned int, unsigned long, unsigned long long,
+    float, double, long double>;
+
+// Stable, readable type names for the report (typeid names are compiler specific).
+template <typename T>
+constexpr const char* bench_type_name() {
+    if constexpr (std::is_same_v<T, char>) return "char";
+    else if constexpr (std::is_same_v<T, wchar_t>) return "wchar_t";
+    else if constexpr (std::is_same_v<T, short int>) return "short";
+    else if constexpr (std::is_same_v<T, int>) return "int";
+    else if constexpr (std::is_same_v<T, long>) return "long";
+    else if constexpr (std::is_same_v<T, long long>) return "long long";
+    else if constexpr (std::is_same_v<T, unsigned char>) return "unsigned char";
+    else if constexpr (std::is_same_v<T, unsigned short int>) return "unsigned short";
+    else if constexpr (std::is_same_v<T, unsigned int>) return "unsigned int";
+    else if constexpr (std::is_same_v<T, unsigned long>) return "unsigned long";
+    else if constexpr (std::is_same_v<T, unsigned long long>) return "unsigned long long";
+    else if constexpr (std::is_same_v<T, float>) return "float";
+    else if constexpr (std::is_same_v<T, double>) return "double";
+    else return "long double";
+}
+
+// The compiler that built this program, for the report.
+std::string bench_compiler() {
+    std::ostringstream name;
+#if defined(__clang__)
+    name << "clang " << __clang_major__ << '.' << __clang_minor__ << '.' << __clang_patchlevel__;
+#elif defined(__GNUC__)
+    name << "gcc " << __GNUC__ << '.' << __GNUC_MINOR__ << '.' << __GNUC_PATCHLEVEL__;
+#elif defined(_MSC_VER)
+    name << "msvc " << _MSC_FULL_VER;
+#else
+    name << "unknown";
+#endif
+    return name.str();
+}
+
+enum class ReportFormat { Json, Csv };
+
+struct BenchOptions {
+    std::vector<unsigned long int> steps{ 5, 1000, 1000000 };
+    unsigned int threads{ 0 };
+    double min_time_ms{ 20.0 };
+    ReportFormat format{ ReportFormat::Json };
+    std::string out_path;
+};
+
+struct BenchRecord {
+    std::string type;
+    std::string operation;   // "add" or "subtract"
+    std::string variant;     // "loop", "closed_form" or "simd"
+    unsigned long int steps{ 0 };
+    unsigned long long calls{ 0 };
+    double ns_per_call{ 0.0 };
+    double steps_per_second{ 0.0 };
+    bool ok{ true };
+    std::string value;       // the Checked<T> value, to compare variants
+};
+
+/// <summary>
+/// start + (block[0] repeated steps times) through checked_sum, one block at a time.
+/// Same value and ok results as add_numbers_loop when block is filled with the increment.
+/// </summary>
+template <typename T>
+Checked<T> add_numbers_blocked(T const& start, std::span<const T> block, unsigned long int const& steps)
+{
+    Checked<T> out{ start, true };
+    for (unsigned long long done = 0; done < steps && !block.empty();) {
+        const std::size_t len = static_cast<std::size_t>(std::min<unsigned long long>(block.size(), steps - done));
+        const CheckedSum<T> partial = checked_sum<T>(block.first(len), out.value);
+        out.value = partial.value;
+        if (!partial.ok) {
+            out.ok = false;
+            break;
+        }
+        done += len;
+    }
+    return out;
+}
+
+// Calls fn until min_time_ms has passed and records the mean time per call.
+template <typename T, typename Fn>
+BenchRecord time_variant(const char* operation, const char* variant, unsigned long int steps,
+    double min_time_ms, Fn&& fn)
+{
+    using clock = std::chrono::steady_clock;
+    BenchRecord record;
+    record.type = bench_type_name<T>();
+    record.operation = operation;
+    record.variant = variant;
+    record.steps = steps;
+
+    Checked<T> result = fn();   // warm-up, and the value reported
+    // calls are made in doubling batches so the clock is read rarely next to short calls
+    const auto begin = clock::now();
+    auto elapsed = clock::duration::zero();
+    for (unsigned long long batch = 1;; batch *= 2) {
+        for (unsigned long long i = 0; i < batch; ++i) result = fn();
+        record.calls += batch;
+        elapsed = clock::now() - begin;
+        if (std::chrono::duration<double, std::milli>(elapsed).count() >= min_time_ms) break;
+    }
+
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    record.ns_per_call = ns / static_cast<double>(record.calls);
+    record.steps_per_second = ns > 0.0 ? static_cast<double>(steps) * static_cast<double>(record.calls) * 1e9 / ns : 0.0;
+    record.ok = result.ok;
+    std::ostringstream value;
+    value.precision(std::numeric_limits<T>::max_digits10);
+    value << +result.value;
+    record.value = value.str();
+    return record;
+}
+
+template <typename T>
+void bench_type(const BenchOptions& options, std::vector<BenchRecord>& records)
+{
+    // inputs are read through volatile so the calls cannot be folded into constants
+    static volatile T zero = T(0);
+    static volatile T max = std::numeric_limits<T>::max();
+
+    for (const unsigned long int steps : options.steps) {
+        T step = static_cast<T>(std::numeric_limits<T>::max() / (steps == 0 ? 1ul : steps));
+        if (step == T(0)) step = T(1);
+        volatile T volatile_step = step;
+        volatile unsigned long int volatile_steps = steps;
+
+        std::vector<T> up_block(std::min<std::size_t>(4096, steps), step);
+        records.push_back(time_variant<T>("add", "loop", steps, options.min_time_ms,
+            [&] { return add_numbers_loop<T>(T(zero), T(volatile_step), static_cast<unsigned long int>(volatile_steps)); }));
+        if constexpr (std::is_integral_v<T>) {
+            records.push_back(time_variant<T>("add", "closed_form", steps, options.min_time_ms,
+                [&] { return add_numbers_closed_form<T>(T(zero), T(volatile_step), static_cast<unsigned long int>(volatile_steps)); }));
+        }
+        records.push_back(time_variant<T>("add", "simd", steps, options.min_time_ms,
+            [&] { return add_numbers_blocked<T>(T(zero), std::span<const T>(up_block), static_cast<unsigned long int>(volatile_steps)); }));
+
+        records.push_back(time_variant<T>("subtract", "loop", steps, options.min_time_ms,
+            [&] { return subtract_numbers_loop<T>(T(max), T(volatile_step), static_cast<unsigned long int>(volatile_steps)); }));
+        if constexpr (std::is_integral_v<T>) {
+            records.push_back(time_variant<T>("subtract", "closed_form", steps, options.min_time_ms,
+                [&] { return subtract_numbers_closed_form<T>(T(max), T(volatile_step), static_cast<unsigned long int>(volatile_steps)); }));
+        }
+        if constexpr (std::is_signed_v<T>) {
+            std::vector<T> down_block(up_block.size(), static_cast<T>(-step));
+            records.push_back(time_variant<T>("subtract", "simd", steps, options.min_time_ms,
+                [&] { return add_numbers_blocked<T>(T(max), std::span<const T>(down_block), static_cast<unsigned long int>(volatile_steps)); }));
+        }
+    }
+}
+
+// One task per type of the list, in list order.
+using BenchTask = void (*)(const BenchOptions&, std::vector<BenchRecord>&);
+
+template <typename... Ts>
+std::vector<BenchTask> bench_tasks(type_list<Ts...>)
+{
+    return { &bench_type<Ts>... };
+}
+
+std::vector<BenchRecord> run_bench_tasks(const BenchOptions& options)
+{
+    const std::vector<BenchTask> tasks = bench_tasks(matrix_types{});
+    std::vector<std::vector<BenchRecord>> per_task(tasks.size());
+    std::atomic<std::size_t> next{ 0 };
+
+    const unsigned int threads = static_cast<unsigned int>(std::min<std::size_t>(std::max(1u, options.threads), tasks.size()));
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (std::size_t i = next.fetch_add(1); i < tasks.size(); i = next.fetch_add(1)) {
+                tasks[i](options, per_task[i]);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    std::vector<BenchRecord> records;
+    for (auto& task_records : per_task) records.insert(records.end(), task_records.begin(), task_records.end());
+    return records;
+}
+
+void write_report(std::ostream& out, const std::vector<BenchRecord>& records, const BenchOptions& options)
+{
+    if (options.format == ReportFormat::Csv) {
+        out << "type,operation,variant,steps,calls,ns_per_call,steps_per_second,ok,value\n";
+        for (const auto& r : records) {
+            out << r.type << ',' << r.operation << ',' << r.variant << ',' << r.steps << ',' << r.calls << ','
+                << r.ns_per_call << ',' << r.steps_per_second << ',' << std::boolalpha << r.ok << ',' << r.value << '\n';
+        }
+        return;
+    }
+
+    out << "{\n  \"context\": {\"compiler\": \"" << bench_compiler() << "\", \"threads\": " << options.threads
+        << ", \"min_time_ms\": " << options.min_time_ms << "},\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const auto& r = records[i];
+        out << "    {\"type\": \"" << r.type << "\", \"operation\": \"" << r.operation << "\", \"variant\": \"" << r.variant
+            << "\", \"steps\": " << r.steps << ", \"calls\": " << r.calls << ", \"ns_per_call\": " << r.ns_per_call
+            << ", \"steps_per_second\": " << r.steps_per_second << ", \"ok\": " << std::boolalpha << r.ok
+            << ", \"value\": \"" << r.value << "\"}" << (i + 1 < records.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+}
+
+// Parses "--name=value" options; returns false (after printing why) on anything unknown.
+bool parse_bench_options(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const std::size_t eq = arg.find('=');
+        const std::string name = arg.substr(0, eq);
+        const std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+        try {
+            if (name == "--steps") {
+                options.steps.clear();
+                std::istringstream list(value);
+                for (std::string item; std::getline(list, item, ',');) options.steps.push_back(std::stoul(item));
+            }
+            else if (name == "--threads") options.threads = static_cast<unsigned int>(std::stoul(value));
+            else if (name == "--min-time-ms") options.min_time_ms = std::stod(value);
+            else if (name == "--format" && (value == "json" || value == "csv")) {
+                options.format = value == "csv" ? ReportFormat::Csv : ReportFormat::Json;
+            }
+            else if (name == "--out" && !value.empty()) options.out_path = value;
+            else {
+                std::cerr << "Unknown benchmark option: " << arg << std::endl;
+                return false;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value for benchmark option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.steps.empty()) {
+        std::cerr << "No step counts given." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int run_benchmarks(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!parse_bench_options(argc, argv, options)) return 1;
+    if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const std::vector<BenchRecord> records = run_bench_tasks(options);
+    if (options.out_path.empty()) {
+        write_report(std::cout, records, options);
+        return 0;
+    }
+
+    std::ofstream out(options.out_path);
+    if (!out) {
+        std::cerr << "Could not open " << options.out_path << " for the benchmark report." << std::endl;
+        return 1;
+    }
+    write_report(out, records, options);
+    return 0;
+}
+
 /// <summary>
 /// Entry point into the application
 /// </summary>
 /// <returns>0 when complete</returns>
-int main()
+int main(int argc, char* argv[])
 {
+    // --bench [options]: time the variants and print a report instead of the tests
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        return run_benchmarks(argc, argv);
+    }
+
     const std::string star_line = std::string(50, '*');
 
     std::cout << "Starting Numeric Underflow / Overflow Tests!" << std::endl;
 
     do_overflow_tests(star_line);
     do_underflow_tests(star_line);
+    do_batch_tests(star_line);
 
     std::cout << std::endl << "All Numeric Underflow / Overflow Tests Complete!" << std::endl;
 
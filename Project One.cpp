@@ -1,123 +1,481 @@
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <string>
-#include <limits> // Required for numeric_limits to handle input buffer clearing
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "CredentialStore.h"   // hashed operator accounts, replaces the hardcoded check
+#include "CustomerStore.h"     // customer records behind DisplayInfo / ChangeCustomerChoice
+#include "EventLog.h"          // audit events for logins and sessions
+#include "InputReader.h"       // buffered fd input, replaces std::cin
+#include "LoginLimiter.h"      // per-user lockout after repeated failed logins
+#include "SessionServer.h"     // --serve: many operator sessions in one process
+
+// Everything a menu handler needs: where commands come from, where replies go, the
+// operator accounts and their failed-login counters, the customers and which customer is
+// selected. Interactive sessions
+// draw menus and prompts and commit every change; batch sessions (a file of commands
+// replayed back-to-back) only print the results and leave commits to the group commit.
+// In server mode every connection gets its own Session over the shared stores.
+struct Session {
+    InputReader& input;
+    std::ostream& out;
+    const CredentialStore& credentials;
+    LoginLimiter& logins;
+    CustomerStore& customers;
+    std::string customer_id;
+    bool interactive;
+
+    void prompt(std::string_view text) {
+        if (interactive) out << text;
+    }
+};
 
 // Forward declarations for the other functions
-void CheckUserPermissionAccess();
-void DisplayInfo();
-void ChangeCustomerChoice();
+void CheckUserPermissionAccess(Session& session);
+void DisplayInfo(Session& session);
+void ChangeCustomerChoice(Session& session);
+void SelectCustomer(Session& session);
+void RunMenu(Session& session);
+int BuildCredentials(const std::string& accounts_path, const std::string& store_path);
+int Serve(const std::string& address, const ServerOptions& options,
+    const CredentialStore& credentials, LoginLimiter& logins, CustomerStore& customers);
 
-int main() {
-    int choice = 0;
+// One menu option: its label, and the handler that runs it (NULL = leave the menu).
+struct MenuEntry {
+    const char* label;
+    void (*run)(Session& session);
+};
+
+// The main menu, indexed by choice - 1. The menu text is generated from this table.
+// Scripts and batch files send these numbers, so entries are only ever appended: Exit
+// stays 4.
+const MenuEntry main_menu[] = {
+    { "Check User Permission Access", CheckUserPermissionAccess },
+    { "Display Customer Information", DisplayInfo },
+    { "Change Customer Choice", ChangeCustomerChoice },
+    { "Exit", NULL },
+    { "Select Customer", SelectCustomer },
+};
+
+// The options of ChangeCustomerChoice, indexed by choice - 1: whether the option takes a new
+// value (typed after the choice, on the same line), how to apply it, and the reply.
+// Recorded sessions from before values existed send the bare choice; for them the
+// value is empty and the customer is left unchanged.
+struct ChangeEntry {
+    const char* label;
+    bool takes_value;
+    bool (*apply)(CustomerStore& customers, std::string_view id, std::string_view value);
+    const char* done;
+};
+
+const ChangeEntry change_menu[] = {
+    { "Service Plan", true,
+        [](CustomerStore& c, std::string_view id, std::string_view v) { return c.set_service_plan(id, v); },
+        "Service Plan updated." },
+    { "Billing Address", true,
+        [](CustomerStore& c, std::string_view id, std::string_view v) { return c.set_billing_address(id, v); },
+        "Billing Address updated." },
+    { "Contact Information", true,
+        [](CustomerStore& c, std::string_view id, std::string_view v) { return c.set_contact(id, v); },
+        "Contact Information updated." },
+    { "Upgrade Account", false,
+        [](CustomerStore& c, std::string_view id, std::string_view) { return c.change_tier(id, +1); },
+        "Account upgraded." },
+    { "Downgrade Account", false,
+        [](CustomerStore& c, std::string_view id, std::string_view) { return c.change_tier(id, -1); },
+        "Account downgraded." },
+};
+
+constexpr int main_menu_size = static_cast<int>(sizeof(main_menu) / sizeof(main_menu[0]));
+constexpr int change_menu_size = static_cast<int>(sizeof(change_menu) / sizeof(change_menu[0]));
+
+// "title\n1. label\n2. label\n...", rendered once per table.
+template <typename Entry, std::size_t N>
+std::string RenderMenu(const char* title, const Entry (&entries)[N]) {
+    std::string text = title;
+    text += '\n';
+    for (std::size_t i = 0; i < N; ++i) {
+        text += std::to_string(i + 1) + ". " + entries[i].label + '\n';
+    }
+    return text;
+}
+
+const std::string& MainMenuText() {
+    static const std::string text = "\n" + RenderMenu("Welcome! Please select an option:", main_menu);
+    return text;
+}
+
+const std::string& ChangeMenuText() {
+    static const std::string text = RenderMenu("Please select an option to change:", change_menu);
+    return text;
+}
+
+// Where the operator accounts live unless --credentials=PATH says otherwise.
+const char* const default_credentials_path = "operators.cred";
+
+// Where the customer log lives unless --customers=PATH says otherwise, and the customer a
+// new session starts with (created in an empty store).
+const char* const default_customers_path = "customers.log";
+const char* const default_customer_id = "CUST12345";
+
+const char* const usage =
+    "usage: project_one [--credentials=PATH] [--customers=PATH] [--seed-customers=N]\n"
+    "                   [--batch FILE] [--serve=ADDRESS] [--max-sessions=N] [--idle-timeout=SECONDS]\n"
+    "                   [--login-attempts=N] [--login-refill=SECONDS]\n"
+    "       project_one --build-credentials ACCOUNTS STORE\n";
+
+// Reads the N of "--name=N" (arg starts with prefix) into value: decimal digits only, the
+// whole text, within [min, max]. Otherwise prints a usage error and leaves value alone.
+template <typename T>
+bool ParseNumberOption(const std::string& arg, const char* prefix, unsigned long long min,
+    unsigned long long max, T& value) {
+    const std::string_view text = std::string_view(arg).substr(std::string_view(prefix).size());
+    unsigned long long number = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), number);
+    if (text.empty() || ec != std::errc() || end != text.data() + text.size() || number < min || number > max) {
+        std::cerr << "Invalid " << prefix << "\"" << text << "\": expected a whole number from " << min
+            << " to " << max << ".\n" << usage;
+        return false;
+    }
+    value = static_cast<T>(number);
+    return true;
+}
+
+// Upper bound of the --*-timeout and --*-refill options, in seconds (a week).
+constexpr unsigned long long max_option_seconds = 7ull * 24 * 60 * 60;
+
+int main(int argc, char* argv[]) {
+    // --build-credentials ACCOUNTS STORE: turn a "username password" text file into a store;
+    //     logins are checked against operators.cred (or --credentials=PATH), so build that
+    // --batch FILE: run the commands in FILE without menus or prompts, then exit
+    // --seed-customers=N: add customers CUST00000001..N (for load tests) before starting
+    // --serve=ADDRESS: run a menu for every connection to tcp:[HOST:]PORT or unix:PATH,
+    //     with --max-sessions=N at once and --idle-timeout=SECONDS before one is dropped
+    // --login-attempts=N, --login-refill=SECONDS: failed logins a user may make in a row,
+    //     and how long until the lockout gives back one more attempt
+    std::string credentials_path = default_credentials_path;
+    std::string customers_path = default_customers_path;
+    std::string batch_path;
+    std::string serve_address;
+    ServerOptions server_options;
+    LoginLimiter::Options login_options;
+    unsigned long seed_customers = 0;
+    long long login_refill_seconds = 0;
+    long long idle_timeout_seconds = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--build-credentials" && i + 2 < argc) {
+            return BuildCredentials(argv[i + 1], argv[i + 2]);
+        }
+        if (arg.rfind("--credentials=", 0) == 0) {
+            credentials_path = arg.substr(std::string("--credentials=").size());
+        }
+        else if (arg.rfind("--customers=", 0) == 0) {
+            customers_path = arg.substr(std::string("--customers=").size());
+        }
+        else if (arg.rfind("--seed-customers=", 0) == 0) {
+            // ids are CUST plus eight digits
+            if (!ParseNumberOption(arg, "--seed-customers=", 0, 99999999, seed_customers)) return 1;
+        }
+        else if (arg == "--batch" && i + 1 < argc) {
+            batch_path = argv[++i];
+        }
+        else if (arg.rfind("--serve=", 0) == 0) {
+            serve_address = arg.substr(std::string("--serve=").size());
+        }
+        else if (arg.rfind("--max-sessions=", 0) == 0) {
+            if (!ParseNumberOption(arg, "--max-sessions=", 1, 1000000, server_options.max_sessions)) return 1;
+        }
+        else if (arg.rfind("--login-attempts=", 0) == 0) {
+            if (!ParseNumberOption(arg, "--login-attempts=", 1, 1000000, login_options.burst)) return 1;
+        }
+        else if (arg.rfind("--login-refill=", 0) == 0) {
+            if (!ParseNumberOption(arg, "--login-refill=", 1, max_option_seconds, login_refill_seconds)) return 1;
+            login_options.refill_interval = std::chrono::seconds(login_refill_seconds);
+        }
+        else if (arg.rfind("--idle-timeout=", 0) == 0) {
+            if (!ParseNumberOption(arg, "--idle-timeout=", 1, max_option_seconds, idle_timeout_seconds)) return 1;
+            server_options.idle_timeout = std::chrono::seconds(idle_timeout_seconds);
+        }
+    }
+
+    // Prompts end in '\n' instead of std::endl; InputReader flushes std::cout before it
+    // waits for input, so output is written in blocks when the menu is fed from a script.
+    unsync_stdio();
+    InputReader input;
+    if (!batch_path.empty() && !input.open_file(batch_path)) {
+        std::cerr << "Could not open batch file " << batch_path << "\n";
+        return 1;
+    }
+
+    CredentialStore credentials;
+    std::string error;
+    if (!credentials.open(credentials_path, &error)) {
+        std::cerr << "Credential store unavailable (" << error << "); every login will be denied.\n"
+            << "Build one with: project_one --build-credentials ACCOUNTS " << credentials_path << "\n";
+    }
+
+    LoginLimiter logins(login_options);
+
+    CustomerStore customers;
+    if (!customers.open(customers_path, &error)) {
+        std::cerr << "Customer store unavailable (" << error << "); changes are kept in memory and lost at exit.\n";
+    }
+    if (customers.size() == 0) {
+        customers.add(default_customer_id, "Jane Doe", "GlobalTech Solutions", "Standard");
+    }
+    for (unsigned long n = 1; n <= seed_customers; ++n) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "CUST%08lu", n);
+        customers.add(id, "Customer", "GlobalTech Solutions");
+    }
+    customers.commit();
+
+    if (!serve_address.empty()) {
+        return Serve(serve_address, server_options, credentials, logins, customers);
+    }
 
-    std::cout << "Created by Anthony McCormack\n\nRangers Lead The Way!\n" << std::endl;
+    Session session{ input, std::cout, credentials, logins, customers, default_customer_id, batch_path.empty() };
+    session.prompt("Created by Anthony McCormack\n\nRangers Lead The Way!\n\n");
+    RunMenu(session);
+    customers.commit();
+    std::cout.flush();
+
+    return 0;
+}
+
+// Main program loop: runs menu choices until Exit or the end of input.
+void RunMenu(Session& session) {
+    int choice = 0;
 
-    // Main program loop
     do {
         // Display the main menu
-        std::cout << "\nWelcome! Please select an option:" << std::endl;
-        std::cout << "1. Check User Permission Access" << std::endl;
-        std::cout << "2. Display Customer Information" << std::endl;
-        std::cout << "3. Change Customer Choice" << std::endl;
-        std::cout << "4. Exit" << std::endl;
-        std::cout << "Enter your choice: ";
+        session.prompt(MainMenuText());
+        session.prompt("Enter your choice: ");
 
         // --- SECURITY VULNERABILITY FIX: Input Validation / DoS Prevention ---
-        // We ensure the input is valid and within the expected range (1-4).
-        while (!(std::cin >> choice) || choice < 1 || choice > 4) {
+        // We ensure the input is valid and within the range of the menu table.
+        for (;;) {
+            const InputReader::Status status = session.input.next_int(choice);
 
-            // FIX: Output error message to the user
-            std::cout << "Invalid input. Please enter a number between 1 and 4." << std::endl;
+            // End of input (e.g. the end of a piped script) leaves the program
+            if (status == InputReader::Status::End) {
+                return;
+            }
+            if (status == InputReader::Status::Ok && choice >= 1 && choice <= main_menu_size) {
+                break;
+            }
 
-            // FIX: Clear the fail flags on the input stream (handles non-numeric input)
-            std::cin.clear();
+            // FIX: Output error message to the user
+            session.out << "Invalid input. Please enter a number between 1 and " << main_menu_size << ".\n";
 
             // FIX: Discard the invalid input left in the buffer (prevents infinite loop/DoS)
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            session.input.skip_line();
 
             // Re-prompt for choice within the loop
-            std::cout << "Enter your choice: ";
+            session.prompt("Enter your choice: ");
         }
         // --- END OF SECURITY FIX ---
 
-        // Process the choice based on user input
-        if (choice == 1) {
-            CheckUserPermissionAccess();
-        }
-        else if (choice == 2) {
-            DisplayInfo();
-        }
-        else if (choice == 3) {
-            ChangeCustomerChoice();
+        // Dispatch through the menu table; the Exit entry has no handler
+        const MenuEntry& entry = main_menu[choice - 1];
+        if (entry.run == NULL) {
+            return;
         }
-        else if (choice == 4) {
-            break; // Exit the loop
-        }
-        /* The redundant 'else' block for invalid input is now implicitly handled
-           by the 'while' loop above, ensuring the input is always 1-4. */
-    } while (true); // Loop indefinitely until choice is 4
-
-    return 0;
+        entry.run(session);
+    } while (true); // Loop indefinitely until Exit is chosen
 }
 
 // NOTE: The vulnerabilities below are not fixed as they are outside the scope of the "main" function fix.
-void CheckUserPermissionAccess() {
-    std::string username, password;
+void CheckUserPermissionAccess(Session& session) {
+    std::string username;
+    std::string_view token, password;
 
     // SECURITY VULNERABILITY IDENTIFIED: Implied Buffer Overflow Risk (via legacy context)
-    std::cout << "Please enter your username: ";
-    std::cin >> username;
+    session.prompt("Please enter your username: ");
+    if (!session.input.next_token(token)) return;
+    username.assign(token.data(), token.size());   // token is only valid until the next read
+
+    session.prompt("Please enter your password: ");
+    if (!session.input.next_token(password)) return;
+
+    // FIX: Brute Force - a user with too many recent failures is turned away before the
+    // password is hashed
+    if (!session.logins.allow(username)) {
+        const long long seconds = (session.logins.retry_after(username).count() + 999) / 1000;
+        EVENT_WARN("login_locked_out", event_log::field("user", username), event_log::field("retry_seconds", seconds));
+        session.out << "Too many failed attempts. Try again in " << seconds << " seconds.\n";
+        return;
+    }
+
+    // FIX: Hardcoded Credentials replaced by salted hashes from the credential store
+    if (session.credentials.verify(username, password)) {
+        session.logins.record_success(username);
+        EVENT_INFO("access_granted", event_log::field("user", username));
+        session.out << "Access Granted.\n";
+    }
+    else {
+        session.logins.record_failure(username);
+        EVENT_WARN("access_denied", event_log::field("user", username));
+        session.out << "Access Denied.\n";
+    }
+}
+
+void DisplayInfo(Session& session) {
+    // A copy, so other sessions can change the customer while it is printed
+    Customer customer;
+    if (!session.customers.get(session.customer_id, customer)) {
+        session.out << "No customer selected.\n";
+        return;
+    }
+
+    session.out << "\n--- Customer Information ---\n"
+        << "Company: " << customer.get_company() << "\n"
+        << "Customer Name: " << customer.get_name() << "\n"
+        << "Customer ID: " << customer.get_id() << "\n"
+        << "Service Plan: " << customer.get_service_plan() << "\n"
+        << "Account Tier: " << customer_tier_names[customer.tier] << "\n"
+        << "Billing Address: " << customer.get_billing_address() << "\n"
+        << "Contact Information: " << customer.get_contact() << "\n"
+        << "-----------------------------\n";
+}
+
+void SelectCustomer(Session& session) {
+    std::string_view id;
 
-    std::cout << "Please enter your password: ";
-    std::cin >> password;
+    session.prompt("Enter the customer ID: ");
+    if (!session.input.next_token(id)) return;
 
-    // SECURITY VULNERABILITY IDENTIFIED: Hardcoded Credentials
-    if (username == "admin" && password == "secure") {
-        std::cout << "Access Granted." << std::endl;
+    if (session.customers.contains(id)) {
+        session.customer_id.assign(id.data(), id.size());
+        session.out << "Customer " << id << " selected.\n";
     }
     else {
-        std::cout << "Access Denied." << std::endl;
+        session.out << "Customer not found.\n";
     }
 }
 
-void DisplayInfo() {
-    std::cout << "\n--- Customer Information ---" << std::endl;
-    std::cout << "Company: GlobalTech Solutions" << std::endl;
-    std::cout << "Customer Name: Jane Doe" << std::endl;
-    std::cout << "Customer ID: CUST12345" << std::endl;
-    std::cout << "-----------------------------" << std::endl;
+// The rest of the current line, trimmed; never reads past it, so the next line stays a
+// menu choice.
+std::string_view ReadValue(Session& session) {
+    std::string_view line;
+    if (!session.input.next_line(line)) return std::string_view();
+    const std::size_t first = line.find_first_not_of(" \t");
+    if (first == std::string_view::npos) return std::string_view();
+    const std::size_t last = line.find_last_not_of(" \t");
+    return line.substr(first, last - first + 1);
 }
 
-void ChangeCustomerChoice() {
-    int choice;
+void ChangeCustomerChoice(Session& session) {
+    int choice = 0;
 
-    std::cout << "Please select an option to change:" << std::endl;
-    std::cout << "1. Service Plan" << std::endl;
-    std::cout << "2. Billing Address" << std::endl;
-    std::cout << "3. Contact Information" << std::endl;
-    std::cout << "4. Upgrade Account" << std::endl;
-    std::cout << "5. Downgrade Account" << std::endl;
-    std::cout << "Enter your choice: ";
+    session.prompt(ChangeMenuText());
+    session.prompt("Enter your choice (1-3 take the new value after it, e.g. \"1 Premium\"): ");
 
-    // SECURITY VULNERABILITY IDENTIFIED: Input Validation Failure (Repeat vulnerability)
-    std::cin >> choice;
+    // FIX: Input Validation - only a number naming a row of the table is accepted
+    const InputReader::Status status = session.input.next_int(choice);
+    if (status == InputReader::Status::End) {
+        return;
+    }
 
-    if (choice == 1) {
-        std::cout << "Service Plan updated." << std::endl;
+    if (status != InputReader::Status::Ok || choice < 1 || choice > change_menu_size) {
+        session.out << "Invalid choice.\n";
+        return;
     }
-    else if (choice == 2) {
-        std::cout << "Billing Address updated." << std::endl;
+
+    const ChangeEntry& entry = change_menu[choice - 1];
+    std::string_view value;
+    if (entry.takes_value) {
+        value = ReadValue(session);
+        if (value.empty()) {
+            session.out << entry.label << " unchanged.\n";
+            return;
+        }
     }
-    else if (choice == 3) {
-        std::cout << "Contact Information updated." << std::endl;
+
+    if (!entry.apply(session.customers, session.customer_id, value)) {
+        session.out << "Could not change customer " << session.customer_id << ".\n";
+        return;
     }
-    else if (choice == 4) {
-        std::cout << "Account upgraded." << std::endl;
+    if (session.interactive && !session.customers.commit()) {
+        session.out << entry.done << " The change could not be saved and lasts until the program exits.\n";
+        return;
     }
-    else if (choice == 5) {
-        std::cout << "Account downgraded." << std::endl;
+    session.out << entry.done << "\n";
+}
+
+// Reads "username password" lines (blank lines and lines starting with '#' are skipped)
+// and writes the hashed credential store. The login prompt reads the password as one
+// token, so a password with whitespace in it could never match and is refused.
+int BuildCredentials(const std::string& accounts_path, const std::string& store_path) {
+    std::ifstream in(accounts_path);
+    if (!in) {
+        std::cerr << "Could not open " << accounts_path << "\n";
+        return 1;
     }
-    else {
-        std::cout << "Invalid choice." << std::endl;
+
+    std::vector<Credential> accounts;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();   // CRLF account files
+        if (line.empty() || line[0] == '#') continue;
+        const std::size_t space = line.find(' ');
+        if (space == std::string::npos || space + 1 == line.size()) {
+            std::cerr << "Skipping malformed account line " << line_number << ".\n";
+            continue;
+        }
+        const std::string password = line.substr(space + 1);
+        if (password.find_first_of(" \t\v\f") != std::string::npos) {
+            std::cerr << "Line " << line_number << ": passwords cannot contain whitespace.\n";
+            return 1;
+        }
+        accounts.push_back(Credential{ line.substr(0, space), password });
+    }
+
+    std::string error;
+    if (!build_credential_file(store_path, accounts, &error)) {
+        std::cerr << "Could not build the credential store: " << error << "\n";
+        return 1;
     }
-}
\ No newline at end of file
+    std::cout << "Wrote " << accounts.size() << " accounts to " << store_path << "\n";
+    return 0;
+}
+
+// Runs the menu for each connection on its own thread. Every session starts as a fresh
+// interactive one (banner, menus, prompts, the same input validation as the console) with
+// the default customer selected; changes commit before they are confirmed, and commits
+// from sessions that change customers at the same moment share one sync.
+int Serve(const std::string& address, const ServerOptions& options,
+    const CredentialStore& credentials, LoginLimiter& logins, CustomerStore& customers) {
+    auto run_session = [&](int fd) {
+        SocketStreambuf buffer(fd);
+        std::ostream out(&buffer);
+        InputReader input(fd, 4096);
+        input.flush_before_read(&out);
+
+        Session session{ input, out, credentials, logins, customers, default_customer_id, true };
+        EVENT_INFO("session_opened", event_log::field("fd", fd));
+        session.prompt("Created by Anthony McCormack\n\nRangers Lead The Way!\n\n");
+        RunMenu(session);
+        out.flush();
+        EVENT_INFO("session_closed", event_log::field("fd", fd));
+    };
+
+    std::cout << "Serving Project One sessions on " << address << "\n";
+    std::cout.flush();
+    std::string error;
+    if (!serve_sessions(address, run_session, options, &error)) {
+        std::cerr << "Server stopped: " << error << "\n";
+        return 1;
+    }
+    return 0;
+}
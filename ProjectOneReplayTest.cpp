@@ -0,0 +1,88 @@
+// ProjectOneReplayTest.cpp : Replays recorded Project One sessions through --batch.
+//
+// The scripts are in the format recorded before the change menu took values: a bare
+// choice per line. Each must still run choice by choice - "3\n1\n4\n" changes nothing
+// and exits - and a value typed after the choice on the same line must still be applied.
+// Takes the path of project_one as its argument; exits non-zero on the first failure.
+// Run by ctest (test project_one_replay).
+//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++failures;
+        }
+    }
+
+    // Runs program --batch on script with a fresh customer log and returns its output.
+    std::string replay(const std::string& program, const char* script)
+    {
+        const std::string script_path = "project_one_replay.txt";
+        const std::string customers_path = "project_one_replay.log";
+        std::remove(customers_path.c_str());
+        std::ofstream(script_path, std::ios::binary) << script;
+
+        const std::string command = "\"" + program + "\" --batch " + script_path + " --customers=" + customers_path
+            + " --credentials=project_one_replay.cred 2>&1";
+        std::string output;
+        if (FILE* pipe = popen(command.c_str(), "r"))
+        {
+            char chunk[4096];
+            for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), pipe)) != 0;) output.append(chunk, n);
+            pclose(pipe);
+        }
+        std::remove(script_path.c_str());
+        std::remove(customers_path.c_str());
+        return output;
+    }
+
+    bool contains(const std::string& text, const char* part)
+    {
+        return text.find(part) != std::string::npos;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::printf("usage: project_one_replay_test PATH_TO_PROJECT_ONE\n");
+        return 2;
+    }
+    const std::string program = argv[1];
+
+    std::string output = replay(program, "3\n1\n4\n2\n");
+    expect(contains(output, "Service Plan unchanged."), "a bare change choice leaves the customer unchanged");
+    expect(!contains(output, "Customer Information"), "the 4 after it is still Exit");
+
+    output = replay(program, "3\n1\n2\n4\n");
+    expect(contains(output, "Customer Information") && !contains(output, "Service Plan: 2"),
+        "the next line is a menu choice, not the value");
+    expect(!contains(output, "Invalid"), "every line of the old script is accepted");
+
+    output = replay(program, "3\r\n2\r\n3\r\n4\r\n2\r\n4\r\n");
+    expect(contains(output, "Billing Address unchanged.") && contains(output, "Account upgraded."),
+        "a CRLF script replays choice by choice");
+
+    output = replay(program, "3\n1 Gold Plan  \n2\n4\n");
+    expect(contains(output, "Service Plan updated.") && contains(output, "Service Plan: Gold Plan\n"),
+        "a value on the choice's line is applied, trimmed");
+
+    std::printf("%s\n", failures == 0 ? "all replay checks passed" : "replay checks failed");
+    return failures == 0 ? 0 : 1;
+}
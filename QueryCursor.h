@@ -0,0 +1,149 @@
+// QueryCursor.h : Row-at-a-time access to query results built on sqlite3_step.
+//
+// Nothing is buffered: each row is read straight from the statement, so memory
+// stays constant no matter how many rows match, the first row is available as
+// soon as SQLite produces it, and the caller may stop at any point.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "sqlite3.h"
+
+// The current row of a stepping statement. Views are valid until the next step.
+class RowView
+{
+public:
+    explicit RowView(sqlite3_stmt* stmt) : stmt_(stmt) {}
+
+    int column_count() const { return sqlite3_column_count(stmt_); }
+    const char* column_name(int column) const { return sqlite3_column_name(stmt_, column); }
+    bool is_null(int column) const { return sqlite3_column_type(stmt_, column) == SQLITE_NULL; }
+
+    // Column value as text; NULL reads as an empty view.
+    std::string_view text(int column) const
+    {
+        const unsigned char* value = sqlite3_column_text(stmt_, column);
+        if (value == NULL) return std::string_view();
+        return std::string_view(reinterpret_cast<const char*>(value),
+            static_cast<std::size_t>(sqlite3_column_bytes(stmt_, column)));
+    }
+
+private:
+    sqlite3_stmt* stmt_;
+};
+
+// Steps `stmt` and hands every row to visitor(const RowView&), which returns false to
+// stop early. Returns SQLITE_DONE when all rows were seen, SQLITE_ROW when the visitor
+// stopped, or the SQLite error code. The statement is reset before returning.
+template <typename Visitor>
+int for_each_row(sqlite3_stmt* stmt, Visitor&& visitor)
+{
+    int result;
+    while ((result = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        if (!visitor(RowView(stmt))) break;
+    }
+    sqlite3_reset(stmt);
+    return result;
+}
+
+// Pull-style cursor: call next() until it returns false, reading row() in between.
+// A cursor opened from SQL text owns (and finalizes) its statement; one attached to a
+// cached statement only resets it.
+class QueryCursor
+{
+public:
+    QueryCursor() = default;
+
+    QueryCursor(sqlite3* db, const std::string& sql)
+    {
+        open(db, sql);
+    }
+
+    ~QueryCursor()
+    {
+        close();
+    }
+
+    QueryCursor(const QueryCursor&) = delete;
+    QueryCursor& operator=(const QueryCursor&) = delete;
+
+    QueryCursor(QueryCursor&& other) noexcept
+        : db_(other.db_), stmt_(other.stmt_), owned_(other.owned_), result_(other.result_)
+    {
+        other.stmt_ = NULL;
+    }
+
+    QueryCursor& operator=(QueryCursor&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            db_ = other.db_;
+            stmt_ = other.stmt_;
+            owned_ = other.owned_;
+            result_ = other.result_;
+            other.stmt_ = NULL;
+        }
+        return *this;
+    }
+
+    // Prepares the first statement in `sql`. Returns false (and ok() == false) on error.
+    bool open(sqlite3* db, const std::string& sql)
+    {
+        close();
+        db_ = db;
+        owned_ = true;
+        result_ = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt_, NULL);
+        if (result_ != SQLITE_OK)
+        {
+            sqlite3_finalize(stmt_);
+            stmt_ = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    // Steps an already prepared (and bound) statement that someone else owns.
+    void attach(sqlite3* db, sqlite3_stmt* stmt)
+    {
+        close();
+        db_ = db;
+        stmt_ = stmt;
+        owned_ = false;
+        result_ = SQLITE_OK;
+    }
+
+    // Advances to the next row. Returns false at the end of the results or on error.
+    bool next()
+    {
+        if (stmt_ == NULL || result_ == SQLITE_DONE) return false;
+        result_ = sqlite3_step(stmt_);
+        return result_ == SQLITE_ROW;
+    }
+
+    RowView row() const { return RowView(stmt_); }
+
+    // False once preparing or stepping failed; error() then has SQLite's message.
+    bool ok() const { return result_ == SQLITE_OK || result_ == SQLITE_ROW || result_ == SQLITE_DONE; }
+    bool done() const { return result_ == SQLITE_DONE; }
+    const char* error() const { return db_ ? sqlite3_errmsg(db_) : "cursor is not open"; }
+
+    void close()
+    {
+        if (stmt_ == NULL) return;
+        if (owned_) sqlite3_finalize(stmt_);
+        else sqlite3_reset(stmt_);
+        stmt_ = NULL;
+    }
+
+private:
+    sqlite3* db_ = NULL;
+    sqlite3_stmt* stmt_ = NULL;
+    bool owned_ = true;
+    int result_ = SQLITE_OK;
+};
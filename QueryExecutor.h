@@ -0,0 +1,216 @@
+// QueryExecutor.h : Connection pool and parallel query executor.
+//
+// One sqlite3* handle serializes every query. ConnectionPool opens N handles with
+// SQLITE_OPEN_NOMUTEX (SQLite then skips its per-connection mutex), and
+// QueryExecutor pins one handle to each worker thread, so no connection is ever
+// shared. Jobs are queued and answered through futures of ResultSet. The injection
+// heuristics (behind the shared verdict cache) run on the worker as well, keeping the
+// submitting thread free.
+//
+// All connections must see the same data: use a database file (WAL lets readers
+// run concurrently) or a shared-cache in-memory URI such as
+// "file:users?mode=memory&cache=shared". An in-memory database only lives while
+// at least one connection to it is open.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sqlite3.h"
+#include "Database.h"
+#include "EventLog.h"
+#include "InjectionDetector.h"
+#include "QueryCursor.h"
+#include "QueryStats.h"
+#include "ResultSet.h"
+#include "StatementCache.h"
+#include "VerdictCache.h"
+
+struct QueryResult
+{
+    bool ok = false;
+    InjectionVerdict verdict = InjectionVerdict::Clean;  // why the query was rejected, if it was
+    std::string error;                                   // SQLite's message when ok == false
+    ResultSet rows;
+};
+
+class ConnectionPool
+{
+public:
+    // Opens `size` connections to options.path; each is meant for a single thread.
+    ConnectionPool(DatabaseOptions options, std::size_t size)
+    {
+        options.extra_open_flags |= SQLITE_OPEN_NOMUTEX;
+        connections_.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sqlite3* db = NULL;
+            if (!open_database(options, &db, &error_))
+            {
+                close();
+                return;
+            }
+            connections_.push_back(db);
+        }
+    }
+
+    ~ConnectionPool()
+    {
+        close();
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    bool ok() const { return !connections_.empty(); }
+    const std::string& error() const { return error_; }
+    std::size_t size() const { return connections_.size(); }
+    sqlite3* connection(std::size_t index) const { return connections_[index]; }
+
+private:
+    void close()
+    {
+        for (sqlite3* db : connections_) sqlite3_close(db);
+        connections_.clear();
+    }
+
+    std::vector<sqlite3*> connections_;
+    std::string error_;
+};
+
+class QueryExecutor
+{
+public:
+    // Starts one worker per pooled connection (hardware_concurrency() when workers == 0).
+    explicit QueryExecutor(const DatabaseOptions& options, std::size_t workers = 0)
+        : pool_(options, workers != 0 ? workers : std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (std::size_t i = 0; i < pool_.size(); ++i)
+        {
+            threads_.emplace_back(&QueryExecutor::work, this, pool_.connection(i));
+        }
+    }
+
+    // Finishes every queued job, then stops the workers.
+    ~QueryExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    QueryExecutor(const QueryExecutor&) = delete;
+    QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+    bool ok() const { return pool_.ok(); }
+    const std::string& error() const { return pool_.error(); }
+    std::size_t workers() const { return threads_.size(); }
+
+    // Queues a query. The future is ready once a worker has checked and run it.
+    std::future<QueryResult> submit(std::string sql)
+    {
+        Job job{ std::move(sql), std::promise<QueryResult>() };
+        std::future<QueryResult> result = job.promise.get_future();
+        if (!ok())
+        {
+            QueryResult failed;
+            failed.error = error();
+            job.promise.set_value(std::move(failed));
+            return result;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(job));
+        }
+        ready_.notify_one();
+        return result;
+    }
+
+private:
+    struct Job
+    {
+        std::string sql;
+        std::promise<QueryResult> promise;
+    };
+
+    // Runs jobs on this worker's own connection. Repeated SQL texts reuse the worker's
+    // prepared statements.
+    void work(sqlite3* db)
+    {
+        StatementCache statements(db, 32);
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            job.promise.set_value(run(db, statements, job.sql));
+        }
+    }
+
+    static QueryResult run(sqlite3* db, StatementCache& statements, const std::string& sql)
+    {
+        QueryResult result;
+        QUERY_STATS_START(check_started);
+        result.verdict = cached_injection_check(sql);
+        QUERY_STATS_STOP(check_started, Check);
+        QUERY_STATS_VERDICT(result.verdict);
+        if (result.verdict != InjectionVerdict::Clean)
+        {
+            EVENT_WARN("sql_injection_rejected", event_log::field("reason", describe(result.verdict)), event_log::field("sql", sql));
+            result.error = std::string("suspected SQL injection (") + describe(result.verdict) + ")";
+            return result;
+        }
+
+        sqlite3_stmt* stmt = statements.prepare(sql);
+        if (stmt == NULL)
+        {
+            result.error = sqlite3_errmsg(db);
+            EVENT_ERROR("sql_query_failed", event_log::field("error", result.error), event_log::field("sql", sql));
+            return result;
+        }
+
+        std::vector<std::string_view> cells;
+        const int step = for_each_row(stmt, [&](const RowView& row) {
+            const int columns = row.column_count();
+            cells.resize(static_cast<std::size_t>(columns));
+            for (int c = 0; c < columns; ++c) cells[static_cast<std::size_t>(c)] = row.text(c);
+            result.rows.add_row(cells.data(), cells.size());
+            return true;
+            });
+
+        result.ok = (step == SQLITE_DONE);
+        if (!result.ok)
+        {
+            result.error = sqlite3_errmsg(db);
+            EVENT_ERROR("sql_query_failed", event_log::field("error", result.error), event_log::field("sql", sql));
+        }
+        return result;
+    }
+
+    ConnectionPool pool_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Job> queue_;
+    bool stopping_ = false;
+};
@@ -0,0 +1,333 @@
+// QueryStats.h : Optional stage timings and injection reject counters for run_query.
+//
+// Built with QUERY_STATS=1 (CMake: -DCS405_QUERY_STATS=ON), the query paths record how long
+// each stage took:
+//   check     the injection check (verdict cache lookup, and the token rules on a miss)
+//   exec      sqlite3_exec, row callbacks included
+//   callback  one call of the row callback (callback or result_set_callback)
+// and count every verdict of the injection check by rule. The SQL text is no longer lowered
+// before the check (the lexer folds case as it reads), so there is no lowering stage.
+//
+// Each stage has an HDR-style log-linear histogram: 32 linear sub-buckets per power of two,
+// so any recorded value is reported within about 3%. Recording is two relaxed atomic adds
+// and a timestamp; the timestamps are TSC ticks on x86-64 (QUERY_STATS_TSC=0 switches to
+// steady_clock), converted to nanoseconds when the stats are read. The TSC must be
+// invariant, which every x86-64 CPU of the last decade is.
+//
+// dump_query_stats() prints count, p50, p99, p999 and max per stage and the reject counts;
+// query_stats_prometheus() renders the same in the Prometheus text format, and
+// serve_query_stats() answers GET /metrics with it over HTTP (see SessionServer.h).
+//
+// With QUERY_STATS=0, the default, the QUERY_STATS_* macros expand to nothing (and
+// QUERY_STATS_CALLBACK(f) to f), their arguments are not evaluated and nothing below is
+// compiled, so the query paths are exactly what they would be without this header.
+//
+
+#pragma once
+
+#ifndef QUERY_STATS
+#define QUERY_STATS 0
+#endif
+
+#if QUERY_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "InjectionDetector.h"
+#include "SessionServer.h"
+
+#ifndef QUERY_STATS_TSC
+#if defined(__x86_64__) || defined(_M_X64)
+#define QUERY_STATS_TSC 1
+#else
+#define QUERY_STATS_TSC 0
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#elif QUERY_STATS_TSC
+#include <x86intrin.h>
+#endif
+
+namespace query_stats
+{
+    enum class Stage : std::uint8_t { Check, Exec, Callback };
+
+    constexpr std::size_t stage_count = 3;
+    constexpr std::size_t verdict_count = 5;   // InjectionVerdict::Clean .. UnbalancedQuotes
+
+    inline const char* stage_name(Stage stage)
+    {
+        static const char* const names[] = { "check", "exec", "callback" };
+        return names[static_cast<int>(stage)];
+    }
+
+    // Metric label for each InjectionVerdict.
+    inline const char* verdict_label(std::size_t verdict)
+    {
+        static const char* const labels[] = { "clean", "multiple_statements", "comment", "tautology", "unbalanced_quotes" };
+        return labels[verdict];
+    }
+
+    // A timestamp in ticks (TSC or steady_clock nanoseconds).
+    inline std::uint64_t now()
+    {
+#if QUERY_STATS_TSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Counts of values in log-linear buckets; safe to record from any number of threads.
+    class Histogram
+    {
+    public:
+        static constexpr int sub_bits = 5;
+        static constexpr std::size_t sub_count = std::size_t(1) << sub_bits;
+        static constexpr std::size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+        void record(std::uint64_t value)
+        {
+            counts_[index(value)].fetch_add(1, std::memory_order_relaxed);
+            total_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        std::uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+        std::uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+        // The highest value equivalent to the one at quantile q (0..1); 0 when empty.
+        std::uint64_t value_at(double q) const
+        {
+            std::uint64_t total = 0;
+            std::uint64_t counts[bucket_count];
+            for (std::size_t i = 0; i < bucket_count; ++i) total += counts[i] = counts_[i].load(std::memory_order_relaxed);
+            if (total == 0) return 0;
+
+            std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total) + 0.999999);
+            if (rank == 0) rank = 1;
+            if (rank > total) rank = total;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank) return highest_in(i);
+            }
+            return highest_in(bucket_count - 1);
+        }
+
+        std::uint64_t max() const { return value_at(1.0); }
+
+    private:
+        // Values below sub_count have a bucket each; above, each power of two is split into
+        // sub_count buckets of equal width.
+        static std::size_t index(std::uint64_t value)
+        {
+            if (value < sub_count) return static_cast<std::size_t>(value);
+            const int shift = highest_bit(value) - sub_bits;
+            return static_cast<std::size_t>(shift + 1) * sub_count + static_cast<std::size_t>((value >> shift) - sub_count);
+        }
+
+        static std::uint64_t highest_in(std::size_t index)
+        {
+            const std::size_t group = index / sub_count, sub = index % sub_count;
+            if (group == 0) return sub;
+            const int shift = static_cast<int>(group) - 1;
+            return ((static_cast<std::uint64_t>(sub_count + sub) + 1) << shift) - 1;
+        }
+
+        static int highest_bit(std::uint64_t value)
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<int>(index);
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+        std::atomic<std::uint64_t> counts_[bucket_count] = {};
+        std::atomic<std::uint64_t> total_{ 0 };
+        std::atomic<std::uint64_t> sum_{ 0 };
+    };
+
+    class Stats
+    {
+    public:
+        Stats() : tick_origin_(now()), clock_origin_(std::chrono::steady_clock::now()) {}
+
+        Stats(const Stats&) = delete;
+        Stats& operator=(const Stats&) = delete;
+
+        Histogram& stage(Stage stage) { return stages_[static_cast<int>(stage)]; }
+        const Histogram& stage(Stage stage) const { return stages_[static_cast<int>(stage)]; }
+
+        void count(InjectionVerdict verdict) { verdicts_[static_cast<int>(verdict)].fetch_add(1, std::memory_order_relaxed); }
+        std::uint64_t verdicts(std::size_t verdict) const { return verdicts_[verdict].load(std::memory_order_relaxed); }
+
+        // Nanoseconds per tick, measured against steady_clock since the stats were created.
+        double ns_per_tick() const
+        {
+#if QUERY_STATS_TSC
+            // a short baseline would make the rate imprecise; wait until it is 20 ms long
+            while (std::chrono::steady_clock::now() - clock_origin_ < std::chrono::milliseconds(20))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            const std::uint64_t ticks = now() - tick_origin_;
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - clock_origin_).count();
+            return ticks != 0 ? ns / static_cast<double>(ticks) : 1.0;
+#else
+            return 1.0;
+#endif
+        }
+
+    private:
+        Histogram stages_[stage_count];
+        std::atomic<std::uint64_t> verdicts_[verdict_count] = {};
+        const std::uint64_t tick_origin_;
+        const std::chrono::steady_clock::time_point clock_origin_;
+    };
+
+    // The process-wide stats. Construction is thread-safe and happens on first use.
+    inline Stats& global()
+    {
+        static Stats stats;
+        return stats;
+    }
+
+    inline void record(Stage stage, std::uint64_t started) { global().stage(stage).record(now() - started); }
+
+    inline void count(InjectionVerdict verdict) { global().count(verdict); }
+
+    // Times each call of a sqlite3_exec row callback.
+    template <int (*Callback)(void*, int, char**, char**)>
+    int timed_callback(void* context, int argc, char** argv, char** names)
+    {
+        const std::uint64_t started = now();
+        const int result = Callback(context, argc, argv, names);
+        record(Stage::Callback, started);
+        return result;
+    }
+}
+
+// Prints count, p50, p99, p999 and max (in ns) per stage, then the verdict counts.
+inline void dump_query_stats(std::ostream& out)
+{
+    const query_stats::Stats& stats = query_stats::global();
+    const double ns = stats.ns_per_tick();
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-10s %12s %12s %12s %12s %12s\n", "stage", "count", "p50 ns", "p99 ns", "p999 ns", "max ns");
+    out << line;
+    for (std::size_t s = 0; s < query_stats::stage_count; ++s)
+    {
+        const query_stats::Histogram& h = stats.stage(static_cast<query_stats::Stage>(s));
+        std::snprintf(line, sizeof(line), "%-10s %12llu %12.0f %12.0f %12.0f %12.0f\n",
+            query_stats::stage_name(static_cast<query_stats::Stage>(s)), static_cast<unsigned long long>(h.count()),
+            static_cast<double>(h.value_at(0.5)) * ns, static_cast<double>(h.value_at(0.99)) * ns,
+            static_cast<double>(h.value_at(0.999)) * ns, static_cast<double>(h.max()) * ns);
+        out << line;
+    }
+    out << "injection verdicts:";
+    for (std::size_t v = 0; v < query_stats::verdict_count; ++v)
+    {
+        out << (v == 0 ? " " : ", ") << query_stats::verdict_label(v) << " " << stats.verdicts(v);
+    }
+    out << std::endl;
+}
+
+// The stats in the Prometheus text exposition format (version 0.0.4).
+inline std::string query_stats_prometheus()
+{
+    const query_stats::Stats& stats = query_stats::global();
+    const double seconds = stats.ns_per_tick() * 1e-9;
+    std::string text;
+    char line[200];
+
+    text += "# HELP cs405_query_stage_seconds Time spent in each run_query stage.\n";
+    text += "# TYPE cs405_query_stage_seconds summary\n";
+    for (std::size_t s = 0; s < query_stats::stage_count; ++s)
+    {
+        const query_stats::Stage stage = static_cast<query_stats::Stage>(s);
+        const query_stats::Histogram& h = stats.stage(stage);
+        for (const double q : { 0.5, 0.99, 0.999 })
+        {
+            std::snprintf(line, sizeof(line), "cs405_query_stage_seconds{stage=\"%s\",quantile=\"%g\"} %.9g\n",
+                query_stats::stage_name(stage), q, static_cast<double>(h.value_at(q)) * seconds);
+            text += line;
+        }
+        std::snprintf(line, sizeof(line), "cs405_query_stage_seconds_sum{stage=\"%s\"} %.9g\n",
+            query_stats::stage_name(stage), static_cast<double>(h.sum()) * seconds);
+        text += line;
+        std::snprintf(line, sizeof(line), "cs405_query_stage_seconds_count{stage=\"%s\"} %llu\n",
+            query_stats::stage_name(stage), static_cast<unsigned long long>(h.count()));
+        text += line;
+    }
+
+    text += "# HELP cs405_injection_verdicts_total Injection check verdicts, by the rule that rejected.\n";
+    text += "# TYPE cs405_injection_verdicts_total counter\n";
+    for (std::size_t v = 0; v < query_stats::verdict_count; ++v)
+    {
+        std::snprintf(line, sizeof(line), "cs405_injection_verdicts_total{verdict=\"%s\"} %llu\n",
+            query_stats::verdict_label(v), static_cast<unsigned long long>(stats.verdicts(v)));
+        text += line;
+    }
+    return text;
+}
+
+// Serves GET /metrics on address (as serve_sessions takes it) until accepting fails.
+inline bool serve_query_stats(const std::string& address, std::string* error = NULL)
+{
+#if !defined(_WIN32)
+    ServerOptions options;
+    options.max_sessions = 8;
+    options.idle_timeout = std::chrono::seconds(5);
+    return serve_sessions(address, [](int fd) {
+        // the request line and headers; the body of a GET is empty
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+        {
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            request.append(buffer, static_cast<std::size_t>(n));
+        }
+
+        const bool metrics = request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0;
+        const std::string body = metrics ? query_stats_prometheus() : "not found\n";
+        const std::string response = std::string(metrics ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 404 Not Found\r\n")
+            + "Content-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size())
+            + "\r\nConnection: close\r\n\r\n" + body;
+        SocketStreambuf out(fd);
+        out.sputn(response.data(), static_cast<std::streamsize>(response.size()));
+        }, options, error);
+#else
+    return serve_sessions(address, [](int) {}, ServerOptions(), error);
+#endif
+}
+
+#define QUERY_STATS_START(name) const std::uint64_t name = ::query_stats::now()
+#define QUERY_STATS_STOP(name, stage) ::query_stats::record(::query_stats::Stage::stage, name)
+#define QUERY_STATS_VERDICT(verdict) ::query_stats::count(verdict)
+#define QUERY_STATS_CALLBACK(f) ::query_stats::timed_callback<f>
+
+#else
+
+#define QUERY_STATS_START(name) ((void)0)
+#define QUERY_STATS_STOP(name, stage) ((void)0)
+#define QUERY_STATS_VERDICT(verdict) ((void)0)
+#define QUERY_STATS_CALLBACK(f) f
+
+#endif
@@ -0,0 +1,214 @@
+// ResultSet.h : Arena-backed, columnar query results.
+//
+// callback() materializes every row as a user_record tuple, which costs three
+// std::string allocations per row plus vector regrowth. ResultSet instead copies
+// the row bytes into a bump arena and keeps one std::string_view per cell, stored
+// column by column. Capacity can be reserved up front, and clear() keeps the arena
+// blocks and column arrays so a ResultSet reused across queries stops allocating once it
+// is warm; the next query's first row sets the column count again.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for bytes. Blocks never move, so views into them stay valid
+// until clear() or destruction.
+class BumpArena
+{
+public:
+    explicit BumpArena(std::size_t block_size = 64 * 1024)
+        : block_size_(block_size == 0 ? 1 : block_size)
+    {
+    }
+
+    BumpArena(BumpArena&&) = default;
+    BumpArena& operator=(BumpArena&&) = default;
+
+    // Makes sure at least `bytes` can be handed out without another allocation.
+    void reserve(std::size_t bytes)
+    {
+        if (remaining_capacity() >= bytes) return;
+        add_block(std::max(bytes, block_size_));
+    }
+
+    // Copies `length` bytes into the arena and returns the copy.
+    const char* copy(const char* data, std::size_t length)
+    {
+        char* out = allocate(length);
+        if (length != 0) std::memcpy(out, data, length);
+        return out;
+    }
+
+    char* allocate(std::size_t length)
+    {
+        while (current_ < blocks_.size() && blocks_[current_].size - blocks_[current_].used < length)
+        {
+            ++current_;
+        }
+        if (current_ == blocks_.size())
+        {
+            add_block(std::max(length, block_size_));
+        }
+        Block& block = blocks_[current_];
+        char* out = block.data.get() + block.used;
+        block.used += length;
+        bytes_used_ += length;
+        return out;
+    }
+
+    // Forgets every allocation but keeps the blocks for reuse.
+    void clear()
+    {
+        for (auto& block : blocks_) block.used = 0;
+        current_ = 0;
+        bytes_used_ = 0;
+    }
+
+    std::size_t bytes_used() const { return bytes_used_; }
+
+    std::size_t bytes_reserved() const
+    {
+        std::size_t total = 0;
+        for (const auto& block : blocks_) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    std::size_t remaining_capacity() const
+    {
+        std::size_t total = 0;
+        for (std::size_t i = current_; i < blocks_.size(); ++i) total += blocks_[i].size - blocks_[i].used;
+        return total;
+    }
+
+    void add_block(std::size_t size)
+    {
+        blocks_.push_back(Block{ std::unique_ptr<char[]>(new char[size]), size, 0 });
+    }
+
+    std::size_t block_size_;
+    std::size_t current_ = 0;
+    std::size_t bytes_used_ = 0;
+    std::vector<Block> blocks_;
+};
+
+class ResultSet
+{
+public:
+    explicit ResultSet(std::size_t arena_block_size = 64 * 1024)
+        : arena_(arena_block_size)
+    {
+    }
+
+    // Pre-sizes the column arrays and the arena for `rows` rows of about `bytes_per_row` bytes.
+    void reserve(std::size_t rows, std::size_t bytes_per_row = 32)
+    {
+        reserved_rows_ = std::max(reserved_rows_, rows);
+        for (std::size_t c = 0; c < column_count_; ++c) columns_[c].reserve(rows);
+        arena_.reserve(rows * bytes_per_row);
+    }
+
+    // Drops the rows, the column count and the names, but keeps column capacity and arena
+    // blocks.
+    void clear()
+    {
+        for (auto& column : columns_) column.clear();
+        arena_.clear();
+        names_.clear();
+        column_count_ = 0;
+        rows_ = 0;
+    }
+
+    // Appends one row, copying the cell bytes into the arena. NULL cells are kept as
+    // views with a null data() pointer. The first row fixes the column count.
+    void add_row(int argc, char** argv, char** column_names = NULL)
+    {
+        if (column_count_ == 0 && argc > 0)
+        {
+            set_columns(static_cast<std::size_t>(argc));
+            if (column_names != NULL)
+            {
+                names_.assign(column_names, column_names + argc);
+            }
+        }
+
+        for (std::size_t c = 0; c < column_count_; ++c)
+        {
+            const char* cell = (c < static_cast<std::size_t>(argc)) ? argv[c] : NULL;
+            append_cell(c, cell, cell ? std::strlen(cell) : 0);
+        }
+        ++rows_;
+    }
+
+    // Same as above for cells that are already views (e.g. from a RowView); a view with a
+    // null data() pointer is stored as NULL.
+    void add_row(const std::string_view* cells, std::size_t count)
+    {
+        if (column_count_ == 0 && count > 0) set_columns(count);
+
+        for (std::size_t c = 0; c < column_count_; ++c)
+        {
+            const std::string_view cell = (c < count) ? cells[c] : std::string_view();
+            append_cell(c, cell.data(), cell.size());
+        }
+        ++rows_;
+    }
+
+    std::size_t size() const { return rows_; }
+    bool empty() const { return rows_ == 0; }
+    std::size_t column_count() const { return column_count_; }
+
+    std::string_view get(std::size_t row, std::size_t column) const { return columns_[column][row]; }
+    bool is_null(std::size_t row, std::size_t column) const { return columns_[column][row].data() == nullptr; }
+
+    // All values of one column, in row order.
+    const std::vector<std::string_view>& column(std::size_t column) const { return columns_[column]; }
+
+    // Column names, when the rows came through sqlite3_exec; empty otherwise.
+    const std::vector<std::string>& column_names() const { return names_; }
+
+    std::size_t bytes_used() const { return arena_.bytes_used(); }
+
+private:
+    // Arrays beyond count stay allocated (and empty) for a wider query later.
+    void set_columns(std::size_t count)
+    {
+        if (columns_.size() < count) columns_.resize(count);
+        column_count_ = count;
+        for (std::size_t c = 0; c < count; ++c) columns_[c].reserve(reserved_rows_);
+    }
+
+    void append_cell(std::size_t column, const char* data, std::size_t length)
+    {
+        if (data == NULL) columns_[column].emplace_back();
+        else columns_[column].emplace_back(arena_.copy(data, length), length);
+    }
+
+    BumpArena arena_;
+    std::vector<std::vector<std::string_view>> columns_;
+    std::vector<std::string> names_;
+    std::size_t column_count_ = 0;
+    std::size_t rows_ = 0;
+    std::size_t reserved_rows_ = 0;
+};
+
+// sqlite3_exec callback that appends each row to the ResultSet passed as the user pointer.
+inline int result_set_callback(void* result_set, int argc, char** argv, char** azColName)
+{
+    static_cast<ResultSet*>(result_set)->add_row(argc, argv, azColName);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// ResultSetTest.cpp : Checks of ResultSet reuse across queries.
+//
+// One ResultSet is filled by queries of different widths, through sqlite3_exec and
+// result_set_callback as run_query does and through views as the executor does. After
+// each clear() the next query must set its own column count and names, and every cell
+// must read back as stored. Exits non-zero on the first failure. Run by ctest (test
+// result_set).
+//
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "sqlite3.h"
+#include "ResultSet.h"
+
+namespace
+{
+    int failures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++failures;
+        }
+    }
+
+    bool exec_into(sqlite3* db, const char* sql, ResultSet& results)
+    {
+        results.clear();
+        return sqlite3_exec(db, sql, result_set_callback, &results, NULL) == SQLITE_OK;
+    }
+}
+
+int main()
+{
+    sqlite3* db = NULL;
+    expect(sqlite3_open(":memory:", &db) == SQLITE_OK, "open an in-memory database");
+    expect(sqlite3_exec(db, "CREATE TABLE USERS(ID INT, NAME TEXT, PASSWORD TEXT);"
+        "INSERT INTO USERS VALUES (1, 'Fred', 'Flinstone'), (2, 'Barney', NULL);", NULL, NULL, NULL) == SQLITE_OK,
+        "create the USERS table");
+
+    ResultSet results;
+    expect(exec_into(db, "SELECT NAME FROM USERS ORDER BY ID", results), "one-column query");
+    expect(results.column_count() == 1 && results.size() == 2, "one column, two rows");
+    expect(results.column_names().size() == 1 && results.column_names()[0] == "NAME", "one column name");
+
+    expect(exec_into(db, "SELECT ID, NAME, PASSWORD FROM USERS ORDER BY ID", results), "three-column query");
+    expect(results.column_count() == 3 && results.size() == 2, "three columns after a one-column query");
+    expect(results.column_names().size() == 3 && results.column_names()[2] == "PASSWORD", "three column names");
+    expect(results.get(0, 0) == "1" && results.get(0, 1) == "Fred" && results.get(0, 2) == "Flinstone", "first row");
+    expect(results.get(1, 1) == "Barney" && results.is_null(1, 2), "second row, NULL password");
+
+    expect(exec_into(db, "SELECT PASSWORD, ID FROM USERS WHERE ID = 1", results), "two-column query");
+    expect(results.column_count() == 2 && results.size() == 1, "two columns after a three-column query");
+    expect(results.get(0, 0) == "Flinstone" && results.get(0, 1) == "1", "two-column row");
+
+    expect(exec_into(db, "SELECT NAME FROM USERS WHERE ID = 3", results), "query without rows");
+    expect(results.column_count() == 0 && results.empty() && results.column_names().empty(), "no rows, no columns");
+
+    results.clear();
+    const std::string_view wide[] = { "a", "b", "c", "d" };
+    results.add_row(wide, 4);
+    expect(results.column_count() == 4 && results.get(0, 3) == "d", "four columns from views");
+    results.clear();
+    results.add_row(wide, 1);
+    expect(results.column_count() == 1 && results.column(0).size() == 1 && results.get(0, 0) == "a",
+        "one column from views after four");
+
+    sqlite3_close(db);
+    std::printf("%s\n", failures == 0 ? "all result set checks passed" : "result set checks failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// ResultWriter.h : Buffered output for USERS query results.
+//
+// dump_results copies every user_record and flushes std::cout with std::endl on each
+// line. ResultWriter formats rows straight from string views into one reusable
+// buffer and hands it to the FILE* only when the buffer passes its threshold (or on
+// flush()), so a dump of millions of rows costs a handful of writes instead of a
+// flush per row.
+//
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+enum class OutputFormat
+{
+    Text,       // same lines as dump_results
+    Csv,        // ID,NAME,PASSWORD header, RFC 4180 quoting
+    JsonLines   // one {"id":...,"name":...,"password":...} object per line
+};
+
+class ResultWriter
+{
+public:
+    // out == NULL discards the output (useful for measuring formatting cost alone).
+    explicit ResultWriter(std::FILE* out = stdout, OutputFormat format = OutputFormat::Text,
+        std::size_t flush_threshold = 64 * 1024)
+        : out_(out), format_(format), flush_threshold_(flush_threshold)
+    {
+        buffer_.reserve(flush_threshold_ + 1024);
+    }
+
+    ~ResultWriter()
+    {
+        flush();
+    }
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    OutputFormat format() const { return format_; }
+
+    // Starts one result listing: the "SQL: ... ==> N records found." line for text,
+    // the column header for CSV, nothing for JSON lines.
+    void begin_results(std::string_view sql, std::size_t count)
+    {
+        switch (format_)
+        {
+        case OutputFormat::Text:
+            append("\nSQL: ");
+            append(sql);
+            append(" ==> ");
+            append_number(count);
+            append(" records found.\n");
+            break;
+        case OutputFormat::Csv:
+            append("ID,NAME,PASSWORD\n");
+            break;
+        case OutputFormat::JsonLines:
+            break;
+        }
+    }
+
+    void write_user(std::string_view id, std::string_view name, std::string_view password)
+    {
+        switch (format_)
+        {
+        case OutputFormat::Text:
+            append("User: ");
+            append(name);
+            append(" [UID=");
+            append(id);
+            append(" PWD=");
+            append(password);
+            append("]\n");
+            break;
+        case OutputFormat::Csv:
+            append_csv(id);
+            buffer_.push_back(',');
+            append_csv(name);
+            buffer_.push_back(',');
+            append_csv(password);
+            buffer_.push_back('\n');
+            break;
+        case OutputFormat::JsonLines:
+            append("{\"id\":");
+            append_json(id);
+            append(",\"name\":");
+            append_json(name);
+            append(",\"password\":");
+            append_json(password);
+            append("}\n");
+            break;
+        }
+
+        if (buffer_.size() >= flush_threshold_) spill();
+    }
+
+    // Writes everything buffered so far and flushes the FILE*.
+    void flush()
+    {
+        spill();
+        if (out_ != NULL) std::fflush(out_);
+    }
+
+    std::size_t bytes_written() const { return bytes_written_ + buffer_.size(); }
+
+private:
+    void append(std::string_view text) { buffer_.append(text.data(), text.size()); }
+
+    void append_number(std::size_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, result.ptr);
+    }
+
+    void append_csv(std::string_view field)
+    {
+        if (field.find_first_of(",\"\r\n") == std::string_view::npos)
+        {
+            append(field);
+            return;
+        }
+        buffer_.push_back('"');
+        for (char c : field)
+        {
+            if (c == '"') buffer_.push_back('"');
+            buffer_.push_back(c);
+        }
+        buffer_.push_back('"');
+    }
+
+    void append_json(std::string_view field)
+    {
+        static const char hex[] = "0123456789abcdef";
+        buffer_.push_back('"');
+        for (char c : field)
+        {
+            const unsigned char u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\')
+            {
+                buffer_.push_back('\\');
+                buffer_.push_back(c);
+            }
+            else if (u < 0x20)
+            {
+                append("\\u00");
+                buffer_.push_back(hex[u >> 4]);
+                buffer_.push_back(hex[u & 0x0f]);
+            }
+            else
+            {
+                buffer_.push_back(c);
+            }
+        }
+        buffer_.push_back('"');
+    }
+
+    // Hands the buffer to the FILE* without flushing it.
+    void spill()
+    {
+        if (buffer_.empty()) return;
+        if (out_ != NULL) std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+        bytes_written_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    std::FILE* out_;
+    OutputFormat format_;
+    std::size_t flush_threshold_;
+    std::size_t bytes_written_ = 0;
+    std::string buffer_;
+};
@@ -0,0 +1,360 @@
+// SQLInjectionBenchmark.cpp : Google Benchmark suite for the SQL injection example.
+//
+// Reports ns/query (or ns/row) and allocations per iteration for:
+//   - the injection heuristics alone, on clean, injected and large inputs (the token rules
+//     and the substring, scalar and regex matchers they replaced)
+//   - run_query against in-memory USERS tables of 4, 10^4 and 10^6 rows
+//   - the callback row materialization (and ResultSet for comparison)
+//   - dump_results writing to a null sink (and ResultWriter for comparison)
+//
+// Build with CMake (target sql_injection_benchmark), or by hand from the repository root:
+//   g++ -std=c++17 -O2 SQLInjectionBenchmark.cpp -o sqlinjection_benchmark -lbenchmark -lsqlite3 -pthread
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <streambuf>
+
+#include <benchmark/benchmark.h>
+
+// The program's functions are benchmarked where they are defined; its main is renamed.
+#define main sqlinjection_main
+#include "SQLInjection.cpp"
+#undef main
+
+// --- Allocation counting ---
+// Every operator new in the process bumps this counter; benchmarks report the delta.
+static std::atomic<std::size_t> g_allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// Measures allocations made between construction and report().
+class AllocationCounter
+{
+public:
+    AllocationCounter() : start_(g_allocations.load(std::memory_order_relaxed)) {}
+
+    void report(benchmark::State& state) const
+    {
+        const double allocations = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - start_);
+        state.counters["allocs/iter"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    std::size_t start_;
+};
+
+// --- Inputs ---
+static const std::string clean_sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'";
+static const std::string injected_sql = "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 'hack'='hack';";
+
+// An ORM-style multi-kilobyte IN-list.
+static const std::string& large_sql()
+{
+    static const std::string sql = [] {
+        std::string text = "SELECT ID, NAME, PASSWORD FROM USERS WHERE ID IN (";
+        for (int i = 0; i < 2000; ++i) text += std::to_string(i) + ", ";
+        text += "0)";
+        return text;
+    }();
+    return sql;
+}
+
+static const std::string& heuristic_input(int which)
+{
+    switch (which)
+    {
+    case 0: return clean_sql;
+    case 1: return injected_sql;
+    default: return large_sql();
+    }
+}
+
+static const char* heuristic_label(int which)
+{
+    switch (which)
+    {
+    case 0: return "clean";
+    case 1: return "injected";
+    default: return "large";
+    }
+}
+
+// An in-memory USERS table with `rows` rows, opened once per size and kept for the run.
+static sqlite3* users_database(std::size_t rows)
+{
+    static std::map<std::size_t, sqlite3*> databases;
+    auto it = databases.find(rows);
+    if (it != databases.end()) return it->second;
+
+    sqlite3* db = NULL;
+    DatabaseOptions options;
+    options.bulk_load = true;
+    std::string error;
+    if (!open_database(options, &db, &error)
+        || !exec_sql(db, "CREATE TABLE USERS(ID INT PRIMARY KEY NOT NULL, NAME TEXT NOT NULL, PASSWORD TEXT NOT NULL);", &error))
+    {
+        std::cerr << "Failed to create the benchmark database. ERROR = " << error << std::endl;
+        std::exit(1);
+    }
+
+    const std::vector< user_record > users = make_users(1, rows);
+    BulkInsertStats stats;
+    if (!bulk_insert(db, "INSERT INTO USERS (ID, NAME, PASSWORD) VALUES (?, ?, ?)", users.begin(), users.end(), stats, &error)
+        || !finish_bulk_load(db, options, &error))
+    {
+        std::cerr << "Failed to seed the benchmark database. ERROR = " << error << std::endl;
+        std::exit(1);
+    }
+
+    databases.emplace(rows, db);
+    return db;
+}
+
+// Swallows everything written to it, standing in for std::cout.
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// --- Heuristic scan alone ---
+static void BM_HeuristicScan(benchmark::State& state)
+{
+    const InjectionDetector& detector = shared_injection_detector();
+    const std::string& sql = heuristic_input(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(detector.check(sql));
+    }
+    allocations.report(state);
+    state.SetLabel(heuristic_label(static_cast<int>(state.range(0))));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sql.size()));
+}
+BENCHMARK(BM_HeuristicScan)->DenseRange(0, 2);
+
+// The substring matcher that check() replaced, with the vectorized prefilter.
+static void BM_HeuristicScanSubstring(benchmark::State& state)
+{
+    const InjectionDetector& detector = shared_injection_detector();
+    const std::string& sql = heuristic_input(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(detector.check_substring(sql));
+    }
+    allocations.report(state);
+    state.SetLabel(heuristic_label(static_cast<int>(state.range(0))));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sql.size()));
+}
+BENCHMARK(BM_HeuristicScanSubstring)->DenseRange(0, 2);
+
+static void BM_HeuristicScanScalar(benchmark::State& state)
+{
+    const InjectionDetector& detector = shared_injection_detector();
+    const std::string& sql = heuristic_input(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(detector.check_scalar(sql));
+    }
+    allocations.report(state);
+    state.SetLabel(heuristic_label(static_cast<int>(state.range(0))));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sql.size()));
+}
+BENCHMARK(BM_HeuristicScanScalar)->DenseRange(0, 2);
+
+// The original lower/trim/find/regex rules, for reference.
+static void BM_HeuristicScanRegex(benchmark::State& state)
+{
+    const InjectionDetector& detector = shared_injection_detector();
+    const std::string& sql = heuristic_input(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(detector.check_regex(sql));
+    }
+    allocations.report(state);
+    state.SetLabel(heuristic_label(static_cast<int>(state.range(0))));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sql.size()));
+}
+BENCHMARK(BM_HeuristicScanRegex)->DenseRange(0, 2);
+
+static void BM_HeuristicScanCached(benchmark::State& state)
+{
+    const std::string& sql = heuristic_input(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cached_injection_check(sql));
+    }
+    allocations.report(state);
+    state.SetLabel(heuristic_label(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_HeuristicScanCached)->DenseRange(0, 2);
+
+// --- Full run_query ---
+static void BM_RunQuery(benchmark::State& state)
+{
+    sqlite3* db = users_database(static_cast<std::size_t>(state.range(0)));
+    const std::string sql = "SELECT * from USERS";
+    std::vector< user_record > records;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        if (!run_query(db, sql, records)) state.SkipWithError("run_query failed");
+        benchmark::DoNotOptimize(records.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_RunQuery)->Arg(4)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_RunQueryResultSet(benchmark::State& state)
+{
+    sqlite3* db = users_database(static_cast<std::size_t>(state.range(0)));
+    const std::string sql = "SELECT * from USERS";
+    ResultSet results;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        if (!run_query(db, sql, results)) state.SkipWithError("run_query failed");
+        benchmark::DoNotOptimize(results.size());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_RunQueryResultSet)->Arg(4)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+static void BM_RunQueryStreaming(benchmark::State& state)
+{
+    sqlite3* db = users_database(static_cast<std::size_t>(state.range(0)));
+    const std::string sql = "SELECT * from USERS";
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        std::size_t bytes = 0;
+        if (!run_query(db, sql, [&bytes](const RowView& row) { bytes += row.text(1).size(); return true; }))
+        {
+            state.SkipWithError("run_query failed");
+        }
+        benchmark::DoNotOptimize(bytes);
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_RunQueryStreaming)->Arg(4)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+// --- Row materialization (per row) ---
+static char row_id[] = "12345";
+static char row_name[] = "Barney";
+static char row_password[] = "Rubble";
+static char column_id[] = "ID";
+static char column_name[] = "NAME";
+static char column_password[] = "PASSWORD";
+static char* row_argv[] = { row_id, row_name, row_password };
+static char* row_columns[] = { column_id, column_name, column_password };
+
+static void BM_CallbackRow(benchmark::State& state)
+{
+    std::vector< user_record > records;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        callback(&records, 3, row_argv, row_columns);
+        if (records.size() == 4096)
+        {
+            state.PauseTiming();
+            records.clear();
+            state.ResumeTiming();
+        }
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_CallbackRow);
+
+static void BM_ResultSetRow(benchmark::State& state)
+{
+    ResultSet results;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        result_set_callback(&results, 3, row_argv, row_columns);
+        if (results.size() == 4096)
+        {
+            state.PauseTiming();
+            results.clear();
+            state.ResumeTiming();
+        }
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_ResultSetRow);
+
+// --- Output ---
+static void BM_DumpResults(benchmark::State& state)
+{
+    const std::vector< user_record > records = make_users(1, static_cast<std::size_t>(state.range(0)));
+    NullBuffer null_buffer;
+    std::streambuf* saved = std::cout.rdbuf(&null_buffer);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        dump_results("SELECT * from USERS", records);
+    }
+    allocations.report(state);
+    std::cout.rdbuf(saved);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_DumpResults)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_WriteResults(benchmark::State& state)
+{
+    const std::vector< user_record > records = make_users(1, static_cast<std::size_t>(state.range(0)));
+    ResultWriter writer(NULL);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        write_results(writer, "SELECT * from USERS", records);
+        writer.flush();
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK(BM_WriteResults)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,266 @@
+// SessionServer.h : Accepts operator sessions over TCP or a UNIX socket.
+//
+// serve_sessions() listens on "tcp:PORT" (loopback), "tcp:HOST:PORT" (an IPv4 address,
+// 0.0.0.0 for every interface) or "unix:PATH", and runs handler(fd) for each connection on
+// its own thread. The menu handlers read with blocking calls and keep their place in the
+// menu on the stack, so a thread per session (cheap while it sleeps in read()) serves them
+// as they are; max_sessions caps the threads, and a connection beyond the cap is told the
+// server is busy and closed. A session that sends nothing for idle_timeout has its reads
+// fail, which ends its menu like the end of input does.
+//
+// SocketStreambuf gives the handler a std::ostream on the connection: output collects in
+// a small buffer and is sent when it fills or the stream is flushed.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+struct ServerOptions
+{
+    std::size_t max_sessions = 512;
+    std::chrono::seconds idle_timeout{ 600 };
+};
+
+#if !defined(_WIN32)
+
+class SocketStreambuf : public std::streambuf
+{
+public:
+    explicit SocketStreambuf(int fd) : fd_(fd)
+    {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    ~SocketStreambuf() override
+    {
+        sync();
+    }
+
+    SocketStreambuf(const SocketStreambuf&) = delete;
+    SocketStreambuf& operator=(const SocketStreambuf&) = delete;
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (!send_buffered()) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        return send_buffered() ? 0 : -1;
+    }
+
+private:
+    // Sends everything buffered; false once the peer has gone.
+    bool send_buffered()
+    {
+        const char* at = pbase();
+        while (at < pptr())
+        {
+            const ssize_t n = ::send(fd_, at, static_cast<std::size_t>(pptr() - at), send_flags);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0)
+            {
+                setp(buffer_, buffer_ + sizeof(buffer_));
+                return false;
+            }
+            at += n;
+        }
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return true;
+    }
+
+#if defined(MSG_NOSIGNAL)
+    static constexpr int send_flags = MSG_NOSIGNAL;   // a closed peer is an error, not SIGPIPE
+#else
+    static constexpr int send_flags = 0;
+#endif
+
+    int fd_;
+    char buffer_[4096];
+};
+
+namespace session_server_detail
+{
+    inline bool fail(std::string* error, const std::string& what)
+    {
+        if (error) *error = what + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // A listening socket for address, or -1.
+    inline int listen_on(const std::string& address, std::string* error)
+    {
+        int fd = -1;
+        if (address.rfind("unix:", 0) == 0)
+        {
+            const std::string path = address.substr(5);
+            sockaddr_un addr{};
+            if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            {
+                if (error) *error = "bad socket path " + path;
+                return -1;
+            }
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) return fail(error, "socket"), -1;
+            ::unlink(path.c_str());   // left behind by an earlier server
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+            {
+                fail(error, "bind " + path);
+                ::close(fd);
+                return -1;
+            }
+        }
+        else if (address.rfind("tcp:", 0) == 0)
+        {
+            std::string host = "127.0.0.1";
+            std::string port = address.substr(4);
+            const std::size_t colon = port.rfind(':');
+            if (colon != std::string::npos)
+            {
+                host = port.substr(0, colon);
+                port = port.substr(colon + 1);
+            }
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            char* end = NULL;
+            const unsigned long number = std::strtoul(port.c_str(), &end, 10);
+            if (port.empty() || *end != '\0' || number > 65535
+                || ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+            {
+                if (error) *error = "bad TCP address " + address.substr(4);
+                return -1;
+            }
+            addr.sin_port = htons(static_cast<std::uint16_t>(number));
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (fd < 0) return fail(error, "socket"), -1;
+            const int on = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+            {
+                fail(error, "bind " + address.substr(4));
+                ::close(fd);
+                return -1;
+            }
+        }
+        else
+        {
+            if (error) *error = "address must be tcp:[HOST:]PORT or unix:PATH";
+            return -1;
+        }
+
+        if (::listen(fd, SOMAXCONN) != 0)
+        {
+            fail(error, "listen");
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    inline void send_all(int fd, const char* text)
+    {
+        SocketStreambuf out(fd);
+        out.sputn(text, static_cast<std::streamsize>(std::strlen(text)));
+    }
+}
+
+// Serves sessions on address until accepting fails. handler(fd) runs on the session's own
+// thread and must not close fd; it is closed when the handler returns.
+inline bool serve_sessions(const std::string& address, const std::function<void(int fd)>& handler,
+    const ServerOptions& options = ServerOptions(), std::string* error = NULL)
+{
+    const int listener = session_server_detail::listen_on(address, error);
+    if (listener < 0) return false;
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::atomic<std::size_t> active{ 0 };
+    for (;;)
+    {
+        const int fd = ::accept(listener, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));   // wait for sessions to end
+                continue;
+            }
+            session_server_detail::fail(error, "accept");
+            ::close(listener);
+            while (active.load() != 0)   // the sessions still use handler and active
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+
+        if (active.fetch_add(1) >= options.max_sessions)
+        {
+            active.fetch_sub(1);
+            session_server_detail::send_all(fd, "Server busy, please try again later.\n");
+            ::close(fd);
+            continue;
+        }
+
+        timeval idle{};
+        idle.tv_sec = static_cast<decltype(idle.tv_sec)>(options.idle_timeout.count());
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+
+        try
+        {
+            std::thread([fd, &handler, &active]() {
+                handler(fd);
+                ::close(fd);
+                active.fetch_sub(1);
+            }).detach();
+        }
+        catch (const std::system_error&)
+        {
+            active.fetch_sub(1);
+            session_server_detail::send_all(fd, "Server busy, please try again later.\n");
+            ::close(fd);
+        }
+    }
+}
+
+#else
+
+inline bool serve_sessions(const std::string& /*address*/, const std::function<void(int fd)>& /*handler*/,
+    const ServerOptions& /*options*/ = ServerOptions(), std::string* error = NULL)
+{
+    if (error) *error = "server mode is not available on Windows";
+    return false;
+}
+
+#endif
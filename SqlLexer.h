@@ -0,0 +1,428 @@
+// SqlLexer.h : Allocation-free SQL tokenizer for the injection rules.
+//
+// SqlLexer walks the SQL text once, left to right, and writes tokens into a caller's fixed
+// buffer (fill) or returns them one at a time (next). A token is its kind and the offset
+// and length of its bytes, so nothing is copied or allocated. It follows
+// SQLite's lexical rules closely enough to tell code from data: a "--" or ';' inside a
+// string literal or a quoted identifier belongs to that token, '' inside a string is an
+// escaped quote, and comments, numbers, parameters, keywords and operators are tokens of
+// their own. A literal, quoted identifier or block comment that runs off the end of the
+// text is returned with `unterminated` set instead of being rejected, so the rules
+// decide what it means.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum class SqlTokenKind : std::uint8_t
+{
+    End,                // no more tokens
+    Identifier,         // bare name or keyword (see SqlToken::keyword)
+    QuotedIdentifier,   // "name", `name` or [name]
+    String,             // 'text'
+    Blob,               // x'hex'
+    Number,             // 12, 1.5e3, .5, 0x1F
+    Parameter,          // ?, ?3, :name, @name, $name
+    Operator,           // see SqlToken::op
+    LeftParen,
+    RightParen,
+    Comma,
+    Semicolon,
+    LineComment,        // -- to the end of the line
+    BlockComment,       // /* ... */
+    Other               // any other byte
+};
+
+// The keywords the rules look at; every other identifier is None.
+enum class SqlKeyword : std::uint8_t
+{
+    None,
+    And, Or, Not, Is, Null, Like, Between, In, True, False,
+    Glob, Regexp, Match, Escape, Collate, Isnull, Notnull, Case, Select,
+    // keywords that end a WHERE clause or a CASE branch
+    Order, Group, Limit, Union, Except, Intersect, Having, Window, Returning, When, Then, Else, End
+};
+
+enum class SqlOperator : std::uint8_t
+{
+    None,
+    Equal,          // = or ==
+    NotEqual,       // != or <>
+    Less, LessEqual, Greater, GreaterEqual,
+    Plus, Minus, Multiply, Divide, Modulo,
+    Concat,         // ||
+    Dot,
+    Other           // & | ~ << >> -> ->>
+};
+
+// Trivial and 12 bytes, so a token is returned in registers and buffers of them cost nothing
+// to declare; SqlToken{} is an End token. Offsets are 32-bit: SQLite refuses statements
+// longer than SQLITE_MAX_SQL_LENGTH (1 GB by default) anyway.
+struct SqlToken
+{
+    SqlTokenKind kind;
+    SqlKeyword keyword;
+    SqlOperator op;
+    bool unterminated;   // a literal, quoted identifier or comment missing its closer
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+namespace sql_lexer_detail
+{
+    // Character classes, so the scanning loops test each byte with one table lookup.
+    enum : std::uint8_t { space = 1, identifier_start = 2, identifier_char = 4, digit = 8, hex_digit = 16 };
+
+    struct ClassTable
+    {
+        std::uint8_t of[256];
+    };
+
+    constexpr ClassTable make_classes() noexcept
+    {
+        ClassTable table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            std::uint8_t bits = 0;
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') bits |= space;
+            // SQLite takes every byte from 0x80 up as part of a name, which covers UTF-8.
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80) bits |= identifier_start | identifier_char;
+            if (c >= '0' && c <= '9') bits |= digit | hex_digit | identifier_char;
+            if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) bits |= hex_digit;
+            if (c == '$') bits |= identifier_char;
+            table.of[c] = bits;
+        }
+        return table;
+    }
+
+    inline constexpr ClassTable classes = make_classes();
+}
+
+class SqlLexer
+{
+public:
+    explicit SqlLexer(std::string_view sql) noexcept : sql_(sql) {}
+
+    // Lexes up to capacity tokens into out and returns how many; 0 once the text is used up.
+    // Callers that walk the whole text take tokens in batches, which keeps the scanning loop
+    // in this one function.
+    std::size_t fill(SqlToken* out, std::size_t capacity) noexcept
+    {
+        const std::size_t n = sql_.size();
+        std::size_t at = pos_;
+        std::size_t count = 0;
+        while (count < capacity)
+        {
+            while (at < n && is_space(sql_[at])) ++at;
+            if (at == n) break;
+            SqlToken& token = out[count++];
+            token = SqlToken{};
+            token.offset = static_cast<std::uint32_t>(at);
+            const std::size_t end = lex(at, token);
+            token.length = static_cast<std::uint32_t>(end - at);
+            at = end;
+        }
+        pos_ = at;
+        return count;
+    }
+
+    // The next token, or an End token once the text is used up.
+    SqlToken next() noexcept
+    {
+        SqlToken token{};
+        if (fill(&token, 1) == 0) token.offset = static_cast<std::uint32_t>(sql_.size());
+        return token;
+    }
+
+    // The bytes of token, quotes and all.
+    std::string_view text(const SqlToken& token) const noexcept { return sql_.substr(token.offset, token.length); }
+
+    static bool is_digit(char c) noexcept { return (sql_lexer_detail::classes.of[static_cast<unsigned char>(c)] & sql_lexer_detail::digit) != 0; }
+    static char to_lower(char c) noexcept { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+    // Whether word spells lower (which is lower case) with ASCII case ignored.
+    static bool equals_folded(std::string_view word, const char* lower) noexcept
+    {
+        for (const char c : word)
+        {
+            if (to_lower(c) != *lower++) return false;
+        }
+        return *lower == '\0';
+    }
+
+private:
+    static bool is_space(char c) noexcept { return (sql_lexer_detail::classes.of[static_cast<unsigned char>(c)] & sql_lexer_detail::space) != 0; }
+    static bool is_hex_digit(char c) noexcept { return (sql_lexer_detail::classes.of[static_cast<unsigned char>(c)] & sql_lexer_detail::hex_digit) != 0; }
+    static bool is_identifier_start(char c) noexcept { return (sql_lexer_detail::classes.of[static_cast<unsigned char>(c)] & sql_lexer_detail::identifier_start) != 0; }
+    static bool is_identifier_char(char c) noexcept { return (sql_lexer_detail::classes.of[static_cast<unsigned char>(c)] & sql_lexer_detail::identifier_char) != 0; }
+
+    // Classifies the token that starts at at (not a space) and returns where it ends.
+    std::size_t lex(std::size_t at, SqlToken& token) const noexcept
+    {
+        const std::size_t n = sql_.size();
+        const char c = sql_[at];
+        const char following = at + 1 < n ? sql_[at + 1] : '\0';
+
+        // names and numbers first: they are most of the tokens
+        if (is_digit(c)) return number(at, token);
+        if (is_identifier_start(c) && !((c == 'x' || c == 'X') && following == '\''))
+        {
+            std::size_t end = at + 1;
+            while (end < n && is_identifier_char(sql_[end])) ++end;
+            token.keyword = keyword(sql_.substr(at, end - at));
+            return is(token, SqlTokenKind::Identifier, end);
+        }
+
+        switch (c)
+        {
+        case '-':
+            if (following == '-')
+            {
+                const std::size_t end = sql_.find('\n', at + 2);
+                return is(token, SqlTokenKind::LineComment, end == std::string_view::npos ? n : end);
+            }
+            if (following == '>') return is(token, SqlOperator::Other, at + (at + 2 < n && sql_[at + 2] == '>' ? 3 : 2));
+            return is(token, SqlOperator::Minus, at + 1);
+        case '/':
+            if (following == '*')
+            {
+                const std::size_t close = sql_.find("*/", at + 2);
+                token.unterminated = close == std::string_view::npos;
+                return is(token, SqlTokenKind::BlockComment, token.unterminated ? n : close + 2);
+            }
+            return is(token, SqlOperator::Divide, at + 1);
+        case '\'': return quoted(at, token, SqlTokenKind::String, '\'');
+        case '"':  return quoted(at, token, SqlTokenKind::QuotedIdentifier, '"');
+        case '`':  return quoted(at, token, SqlTokenKind::QuotedIdentifier, '`');
+        case '[':
+        {
+            const std::size_t close = sql_.find(']', at + 1);
+            token.unterminated = close == std::string_view::npos;
+            return is(token, SqlTokenKind::QuotedIdentifier, token.unterminated ? n : close + 1);
+        }
+        case ';': return is(token, SqlTokenKind::Semicolon, at + 1);
+        case '(': return is(token, SqlTokenKind::LeftParen, at + 1);
+        case ')': return is(token, SqlTokenKind::RightParen, at + 1);
+        case ',': return is(token, SqlTokenKind::Comma, at + 1);
+        case '=': return is(token, SqlOperator::Equal, at + (following == '=' ? 2 : 1));
+        case '<':
+            if (following == '=') return is(token, SqlOperator::LessEqual, at + 2);
+            if (following == '>') return is(token, SqlOperator::NotEqual, at + 2);
+            if (following == '<') return is(token, SqlOperator::Other, at + 2);
+            return is(token, SqlOperator::Less, at + 1);
+        case '>':
+            if (following == '=') return is(token, SqlOperator::GreaterEqual, at + 2);
+            if (following == '>') return is(token, SqlOperator::Other, at + 2);
+            return is(token, SqlOperator::Greater, at + 1);
+        case '!':
+            if (following == '=') return is(token, SqlOperator::NotEqual, at + 2);
+            return is(token, SqlTokenKind::Other, at + 1);
+        case '|':
+            if (following == '|') return is(token, SqlOperator::Concat, at + 2);
+            return is(token, SqlOperator::Other, at + 1);
+        case '+': return is(token, SqlOperator::Plus, at + 1);
+        case '*': return is(token, SqlOperator::Multiply, at + 1);
+        case '%': return is(token, SqlOperator::Modulo, at + 1);
+        case '&':
+        case '~': return is(token, SqlOperator::Other, at + 1);
+        case '.':
+            if (is_digit(following)) return number(at, token);
+            return is(token, SqlOperator::Dot, at + 1);
+        case '?':
+        {
+            std::size_t end = at + 1;
+            while (end < n && is_digit(sql_[end])) ++end;
+            return is(token, SqlTokenKind::Parameter, end);
+        }
+        case ':':
+        case '@':
+        case '$':
+        case '#':
+        {
+            std::size_t end = at + 1;
+            while (end < n && is_identifier_char(sql_[end])) ++end;
+            return is(token, end > at + 1 ? SqlTokenKind::Parameter : SqlTokenKind::Other, end);
+        }
+        case 'x':
+        case 'X':
+            return quoted(at + 1, token, SqlTokenKind::Blob, '\'');
+        default:
+            return is(token, SqlTokenKind::Other, at + 1);
+        }
+    }
+
+    static std::size_t is(SqlToken& token, SqlTokenKind kind, std::size_t end) noexcept
+    {
+        token.kind = kind;
+        return end;
+    }
+
+    static std::size_t is(SqlToken& token, SqlOperator op, std::size_t end) noexcept
+    {
+        token.kind = SqlTokenKind::Operator;
+        token.op = op;
+        return end;
+    }
+
+    // A token closed by quote, where a doubled quote stands for one; open is its opening quote.
+    std::size_t quoted(std::size_t open, SqlToken& token, SqlTokenKind kind, char quote) const noexcept
+    {
+        token.kind = kind;
+        std::size_t at = open + 1;
+        for (;;)
+        {
+            const std::size_t close = sql_.find(quote, at);
+            if (close == std::string_view::npos)
+            {
+                token.unterminated = true;
+                return sql_.size();
+            }
+            if (close + 1 < sql_.size() && sql_[close + 1] == quote)
+            {
+                at = close + 2;
+                continue;
+            }
+            return close + 1;
+        }
+    }
+
+    std::size_t number(std::size_t at, SqlToken& token) const noexcept
+    {
+        token.kind = SqlTokenKind::Number;
+        const std::size_t n = sql_.size();
+        std::size_t end = at;
+        if (sql_[end] == '0' && end + 2 < n && to_lower(sql_[end + 1]) == 'x' && is_hex_digit(sql_[end + 2]))
+        {
+            end += 2;
+            while (end < n && is_hex_digit(sql_[end])) ++end;
+            return end;
+        }
+        while (end < n && is_digit(sql_[end])) ++end;
+        if (end < n && sql_[end] == '.')
+        {
+            ++end;
+            while (end < n && is_digit(sql_[end])) ++end;
+        }
+        if (end < n && to_lower(sql_[end]) == 'e')
+        {
+            std::size_t exponent = end + 1;
+            if (exponent < n && (sql_[exponent] == '+' || sql_[exponent] == '-')) ++exponent;
+            if (exponent < n && is_digit(sql_[exponent]))
+            {
+                end = exponent;
+                while (end < n && is_digit(sql_[end])) ++end;
+            }
+        }
+        return end;
+    }
+
+    // Identifiers are keyed on their length and first letter, so each one is compared with
+    // at most two keywords.
+    static constexpr std::size_t key(std::size_t size, char first) noexcept { return size << 8 | static_cast<unsigned char>(first); }
+
+    static SqlKeyword keyword(std::string_view word) noexcept
+    {
+        switch (key(word.size(), to_lower(word.front())))
+        {
+        case key(2, 'i'):
+            if (equals_folded(word, "is")) return SqlKeyword::Is;
+            if (equals_folded(word, "in")) return SqlKeyword::In;
+            break;
+        case key(2, 'o'):
+            if (equals_folded(word, "or")) return SqlKeyword::Or;
+            break;
+        case key(3, 'a'):
+            if (equals_folded(word, "and")) return SqlKeyword::And;
+            break;
+        case key(3, 'e'):
+            if (equals_folded(word, "end")) return SqlKeyword::End;
+            break;
+        case key(3, 'n'):
+            if (equals_folded(word, "not")) return SqlKeyword::Not;
+            break;
+        case key(4, 'c'):
+            if (equals_folded(word, "case")) return SqlKeyword::Case;
+            break;
+        case key(4, 'e'):
+            if (equals_folded(word, "else")) return SqlKeyword::Else;
+            break;
+        case key(4, 'g'):
+            if (equals_folded(word, "glob")) return SqlKeyword::Glob;
+            break;
+        case key(4, 'l'):
+            if (equals_folded(word, "like")) return SqlKeyword::Like;
+            break;
+        case key(4, 'n'):
+            if (equals_folded(word, "null")) return SqlKeyword::Null;
+            break;
+        case key(4, 't'):
+            if (equals_folded(word, "true")) return SqlKeyword::True;
+            if (equals_folded(word, "then")) return SqlKeyword::Then;
+            break;
+        case key(4, 'w'):
+            if (equals_folded(word, "when")) return SqlKeyword::When;
+            break;
+        case key(5, 'f'):
+            if (equals_folded(word, "false")) return SqlKeyword::False;
+            break;
+        case key(5, 'g'):
+            if (equals_folded(word, "group")) return SqlKeyword::Group;
+            break;
+        case key(5, 'l'):
+            if (equals_folded(word, "limit")) return SqlKeyword::Limit;
+            break;
+        case key(5, 'm'):
+            if (equals_folded(word, "match")) return SqlKeyword::Match;
+            break;
+        case key(5, 'o'):
+            if (equals_folded(word, "order")) return SqlKeyword::Order;
+            break;
+        case key(5, 'u'):
+            if (equals_folded(word, "union")) return SqlKeyword::Union;
+            break;
+        case key(6, 'e'):
+            if (equals_folded(word, "except")) return SqlKeyword::Except;
+            if (equals_folded(word, "escape")) return SqlKeyword::Escape;
+            break;
+        case key(6, 'h'):
+            if (equals_folded(word, "having")) return SqlKeyword::Having;
+            break;
+        case key(6, 'i'):
+            if (equals_folded(word, "isnull")) return SqlKeyword::Isnull;
+            break;
+        case key(6, 'r'):
+            if (equals_folded(word, "regexp")) return SqlKeyword::Regexp;
+            break;
+        case key(6, 's'):
+            if (equals_folded(word, "select")) return SqlKeyword::Select;
+            break;
+        case key(6, 'w'):
+            if (equals_folded(word, "window")) return SqlKeyword::Window;
+            break;
+        case key(7, 'b'):
+            if (equals_folded(word, "between")) return SqlKeyword::Between;
+            break;
+        case key(7, 'c'):
+            if (equals_folded(word, "collate")) return SqlKeyword::Collate;
+            break;
+        case key(7, 'n'):
+            if (equals_folded(word, "notnull")) return SqlKeyword::Notnull;
+            break;
+        case key(9, 'i'):
+            if (equals_folded(word, "intersect")) return SqlKeyword::Intersect;
+            break;
+        case key(9, 'r'):
+            if (equals_folded(word, "returning")) return SqlKeyword::Returning;
+            break;
+        default:
+            break;
+        }
+        return SqlKeyword::None;
+    }
+
+    std::string_view sql_;
+    std::size_t pos_ = 0;
+};
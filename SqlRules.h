@@ -0,0 +1,1024 @@
+// SqlRules.h : The injection rules, evaluated on the SqlLexer token stream.
+//
+// sql_rules::scan() lexes the SQL text once and folds every token into four findings:
+//   multiple_statements  a token after the first ';'
+//   comment              a "--" or "/* */" comment outside literals
+//   tautology            an OR operand that is always true, or that cannot be shown not to be
+//   unbalanced_quotes    a string, blob or quoted identifier without its closing quote
+// The rules see tokens rather than bytes, so a "--" or ';' inside 'a literal' is data.
+//
+// For the tautology rule the tokens of each OR operand, up to the next OR, ',', ')', ';' or
+// clause keyword at its own nesting level, are kept in a fixed buffer and constant-folded
+// with SQLite's rules: literals, arithmetic, bit operators, comparisons, IS, LIKE, GLOB,
+// BETWEEN, IN, CASE, COLLATE, NOT, AND, OR and NULL. A column compared with itself folds like
+// equal constants, so "or 3>2", "or name=name", "or 'a' like '%'" and "or not 0" are all
+// caught, while "or 1=2" and "or name='Fred'" are not.
+//
+// The rule fails closed. An operand is clean only when it folds to false or NULL, or when
+// its value depends on a column or a bound parameter. One the folder cannot parse, one built
+// only from constants it cannot compute ("or 'a'||'b'", "or abs(1)"), and one longer than
+// the buffer all count as tautologies. IN lists of literals do not fill the buffer: past a
+// point their items are summed up as they stream by (see Operand). Nothing is allocated.
+//
+
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "SqlLexer.h"
+
+namespace sql_rules
+{
+    struct Findings
+    {
+        bool multiple_statements = false;
+        bool comment = false;
+        bool tautology = false;
+        bool unbalanced_quotes = false;
+    };
+
+    // A folded value. Comparisons and logic produce integers 1 and 0, as in SQLite.
+    struct Value
+    {
+        // Unknown: depends on the data (a column, a parameter, a subquery over a table).
+        // Opaque: does not depend on the data, but the folder cannot compute or parse it.
+        enum class Kind : std::uint8_t { Unknown, Opaque, Null, Number, Text, Column };
+
+        Kind kind = Kind::Unknown;
+        bool integer = false;
+        bool nocase = false;     // Text under COLLATE NOCASE
+        double number = 0.0;
+        std::string_view text;   // Text: between the quotes, '' still doubled; Column: the name
+
+        static Value unknown() noexcept { return Value(); }
+        static Value opaque() noexcept { Value v; v.kind = Kind::Opaque; return v; }
+        static Value null() noexcept { Value v; v.kind = Kind::Null; return v; }
+        static Value of(double number, bool integer) noexcept
+        {
+            if (std::isnan(number)) return null();   // inf - inf and the like are NULL in SQLite
+            Value v;
+            v.kind = Kind::Number;
+            v.number = integer ? std::trunc(number) : number;
+            v.integer = integer;
+            return v;
+        }
+        static Value of(bool truth) noexcept { return of(truth ? 1.0 : 0.0, true); }
+    };
+
+    // Folds a range of tokens as one expression; every token must be used.
+    class Folder
+    {
+    public:
+        Folder(const SqlToken* tokens, std::size_t count, std::string_view sql) noexcept
+            : tokens_(tokens), count_(count), sql_(sql)
+        {
+        }
+
+        // The value of the whole range: Opaque when it is not an expression the folder can read.
+        Value fold() noexcept
+        {
+            const Value value = or_expression();
+            return failed_ || at_ != count_ ? Value::opaque() : value;
+        }
+
+        // SQLite's truth of a value: 1, 0, NULL, or Unknown when the folder cannot tell.
+        enum class Truth : std::uint8_t { False, True, Null, Unknown };
+
+        static Truth truth(const Value& v) noexcept
+        {
+            switch (v.kind)
+            {
+            case Value::Kind::Number: return v.number != 0.0 ? Truth::True : Truth::False;
+            case Value::Kind::Text:   return text_number(v.text).number != 0.0 ? Truth::True : Truth::False;
+            case Value::Kind::Null:   return Truth::Null;
+            default:                  return Truth::Unknown;
+            }
+        }
+
+    private:
+        // --- Grammar, loosest binding first ---
+        Value or_expression() noexcept
+        {
+            Value value = and_expression();
+            while (at_keyword(SqlKeyword::Or))
+            {
+                ++at_;
+                value = logical_or(value, and_expression());
+            }
+            return value;
+        }
+
+        Value and_expression() noexcept
+        {
+            Value value = not_expression();
+            while (at_keyword(SqlKeyword::And))
+            {
+                ++at_;
+                value = logical_and(value, not_expression());
+            }
+            return value;
+        }
+
+        Value not_expression() noexcept
+        {
+            if (at_keyword(SqlKeyword::Not))
+            {
+                ++at_;
+                return logical_not(not_expression());
+            }
+            return predicate();
+        }
+
+        Value predicate() noexcept
+        {
+            Value left = bits();
+            while (!failed_ && at_ < count_)
+            {
+                const SqlToken& token = tokens_[at_];
+                if (token.kind == SqlTokenKind::Operator && token.op >= SqlOperator::Equal && token.op <= SqlOperator::GreaterEqual)
+                {
+                    ++at_;
+                    left = compare(left, token.op, bits());
+                    continue;
+                }
+                if (token.keyword == SqlKeyword::Is)
+                {
+                    ++at_;
+                    const bool negate = take_keyword(SqlKeyword::Not);
+                    const Value same = is(left, bits());
+                    left = negate ? logical_not(same) : same;
+                    continue;
+                }
+                if (token.keyword == SqlKeyword::Isnull || token.keyword == SqlKeyword::Notnull)
+                {
+                    ++at_;
+                    const Value same = is(left, Value::null());
+                    left = token.keyword == SqlKeyword::Notnull ? logical_not(same) : same;
+                    continue;
+                }
+
+                const SqlKeyword following = at_ + 1 < count_ ? tokens_[at_ + 1].keyword : SqlKeyword::None;
+                const bool negate = token.keyword == SqlKeyword::Not
+                    && (following == SqlKeyword::Like || following == SqlKeyword::Glob || following == SqlKeyword::Regexp
+                        || following == SqlKeyword::Match || following == SqlKeyword::Between || following == SqlKeyword::In
+                        || following == SqlKeyword::Null);
+                const SqlKeyword keyword = negate ? following : token.keyword;
+                Value result;
+                if (negate && keyword == SqlKeyword::Null)
+                {
+                    at_ += 2;   // "x NOT NULL"
+                    result = is(left, Value::null());
+                }
+                else if (keyword == SqlKeyword::Like)
+                {
+                    at_ += negate ? 2 : 1;
+                    const Value pattern = bits();
+                    result = take_keyword(SqlKeyword::Escape) ? like_escaped(left, pattern, bits()) : like(left, pattern);
+                }
+                else if (keyword == SqlKeyword::Glob)
+                {
+                    at_ += negate ? 2 : 1;
+                    result = glob(left, bits());
+                }
+                else if (keyword == SqlKeyword::Regexp || keyword == SqlKeyword::Match)
+                {
+                    // user functions in SQLite; nothing to fold
+                    at_ += negate ? 2 : 1;
+                    const Value pattern = bits();
+                    result = left.kind == Value::Kind::Null || pattern.kind == Value::Kind::Null ? Value::null() : undecided(left, pattern);
+                }
+                else if (keyword == SqlKeyword::Between)
+                {
+                    at_ += negate ? 2 : 1;
+                    const Value low = bits();
+                    if (!take_keyword(SqlKeyword::And)) return fail();
+                    const Value high = bits();
+                    result = logical_and(compare(left, SqlOperator::GreaterEqual, low), compare(left, SqlOperator::LessEqual, high));
+                }
+                else if (keyword == SqlKeyword::In)
+                {
+                    at_ += negate ? 2 : 1;
+                    result = in_list(left);
+                }
+                else
+                {
+                    break;
+                }
+                left = negate ? logical_not(result) : result;
+            }
+            return left;
+        }
+
+        Value in_list(const Value& left) noexcept
+        {
+            if (!take_kind(SqlTokenKind::LeftParen)) return fail();
+            Value found = Value::of(false);
+            if (take_kind(SqlTokenKind::RightParen)) return found;
+            if (take_keyword(SqlKeyword::Select)) return undecided(left, group());
+            do
+            {
+                found = logical_or(found, compare(left, SqlOperator::Equal, or_expression()));
+            } while (take_kind(SqlTokenKind::Comma));
+            if (!take_kind(SqlTokenKind::RightParen)) return fail();
+            return found;
+        }
+
+        // & | << >>, which bind looser than + and -
+        Value bits() noexcept
+        {
+            Value value = sum();
+            while (at_ < count_ && tokens_[at_].kind == SqlTokenKind::Operator && tokens_[at_].op == SqlOperator::Other)
+            {
+                const std::string_view op = text(tokens_[at_]);
+                if (op != "&" && op != "|" && op != "<<" && op != ">>") break;
+                ++at_;
+                value = bitwise(value, op, sum());
+            }
+            return value;
+        }
+
+        Value sum() noexcept
+        {
+            Value value = product();
+            while (at_operator(SqlOperator::Plus) || at_operator(SqlOperator::Minus))
+            {
+                const SqlOperator op = tokens_[at_++].op;
+                value = arithmetic(value, op, product());
+            }
+            return value;
+        }
+
+        Value product() noexcept
+        {
+            Value value = concatenation();
+            while (at_operator(SqlOperator::Multiply) || at_operator(SqlOperator::Divide) || at_operator(SqlOperator::Modulo))
+            {
+                const SqlOperator op = tokens_[at_++].op;
+                value = arithmetic(value, op, concatenation());
+            }
+            return value;
+        }
+
+        // || and the JSON operators -> and ->>, which bind tighter than * / %
+        Value concatenation() noexcept
+        {
+            Value value = collated();
+            while (at_operator(SqlOperator::Concat) || (at_operator(SqlOperator::Other) && text(tokens_[at_]).front() == '-'))
+            {
+                ++at_;
+                const Value right = collated();
+                value = value.kind == Value::Kind::Null || right.kind == Value::Kind::Null ? Value::null() : undecided(value, right);
+            }
+            return value;
+        }
+
+        Value collated() noexcept
+        {
+            Value value = unary();
+            while (take_keyword(SqlKeyword::Collate))
+            {
+                if (at_ == count_ || (tokens_[at_].kind != SqlTokenKind::Identifier && tokens_[at_].kind != SqlTokenKind::QuotedIdentifier))
+                    return fail();
+                const SqlToken& name = tokens_[at_++];
+                const std::string_view collation = name.kind == SqlTokenKind::QuotedIdentifier ? inner(name) : text(name);
+                if (SqlLexer::equals_folded(collation, "nocase"))
+                    value.nocase = true;
+                else if (SqlLexer::equals_folded(collation, "rtrim"))
+                    value = value.kind == Value::Kind::Text ? Value::opaque() : value;
+                else if (!SqlLexer::equals_folded(collation, "binary"))
+                    return fail();   // an application collation; SQLite would need it registered
+            }
+            return value;
+        }
+
+        Value unary() noexcept
+        {
+            if (at_operator(SqlOperator::Plus))
+            {
+                ++at_;
+                return unary();
+            }
+            if (at_operator(SqlOperator::Minus))
+            {
+                ++at_;
+                return arithmetic(Value::of(0.0, true), SqlOperator::Minus, unary());
+            }
+            if (at_operator(SqlOperator::Other) && text(tokens_[at_]) == "~")
+            {
+                ++at_;
+                return bitwise(unary(), "~", Value::null());
+            }
+            return primary();
+        }
+
+        Value primary() noexcept
+        {
+            if (at_ == count_) return fail();
+            const SqlToken& token = tokens_[at_++];
+            switch (token.kind)
+            {
+            case SqlTokenKind::Number: return number(text(token));
+            case SqlTokenKind::String:
+            {
+                Value v;
+                v.kind = Value::Kind::Text;
+                v.text = inner(token);
+                return v;
+            }
+            case SqlTokenKind::Blob:
+                return Value::opaque();
+            case SqlTokenKind::Parameter:
+                return Value::unknown();
+            case SqlTokenKind::LeftParen:
+            {
+                if (take_keyword(SqlKeyword::Select)) return group();
+                const Value value = or_expression();
+                if (!take_kind(SqlTokenKind::RightParen)) return fail();
+                return value;
+            }
+            case SqlTokenKind::Identifier:
+                switch (token.keyword)
+                {
+                case SqlKeyword::Null:  return Value::null();
+                case SqlKeyword::True:  return Value::of(true);
+                case SqlKeyword::False: return Value::of(false);
+                case SqlKeyword::Case:  return case_expression();
+                case SqlKeyword::None:  return column(token);
+                default:                return fail();
+                }
+            case SqlTokenKind::QuotedIdentifier:
+                return column(token);
+            default:
+                return fail();
+            }
+        }
+
+        // A column name, table.column, or a function call.
+        Value column(const SqlToken& first) noexcept
+        {
+            if (take_kind(SqlTokenKind::LeftParen)) return group();
+
+            Value v;
+            v.kind = Value::Kind::Column;
+            v.text = first.kind == SqlTokenKind::QuotedIdentifier ? inner(first) : text(first);
+            while (at_operator(SqlOperator::Dot))
+            {
+                ++at_;
+                if (at_ == count_ || (tokens_[at_].kind != SqlTokenKind::Identifier && tokens_[at_].kind != SqlTokenKind::QuotedIdentifier))
+                    return fail();
+                const SqlToken& last = tokens_[at_++];
+                v.text = sql_.substr(first.offset, last.offset + last.length - first.offset);
+            }
+            return v;
+        }
+
+        // The rest of a function's arguments or a subquery, up to its ')'. Unknown when a name,
+        // parameter or count(*) inside reads the data, Opaque when only constants do.
+        Value group() noexcept
+        {
+            bool data = false;
+            for (int depth = 1; depth > 0; ++at_)
+            {
+                if (at_ == count_) return fail();
+                const SqlToken& token = tokens_[at_];
+                if (token.kind == SqlTokenKind::LeftParen) ++depth;
+                if (token.kind == SqlTokenKind::RightParen) --depth;
+                data = data || (token.kind == SqlTokenKind::Identifier && token.keyword == SqlKeyword::None)
+                    || token.kind == SqlTokenKind::QuotedIdentifier || token.kind == SqlTokenKind::Parameter
+                    || (token.kind == SqlTokenKind::Operator && token.op == SqlOperator::Multiply
+                        && tokens_[at_ - 1].kind == SqlTokenKind::LeftParen);
+            }
+            return data ? Value::unknown() : Value::opaque();
+        }
+
+        // CASE [base] WHEN ... THEN ... [ELSE ...] END, after the CASE.
+        Value case_expression() noexcept
+        {
+            const bool has_base = !at_keyword(SqlKeyword::When);
+            const Value base = has_base ? or_expression() : Value::null();
+            if (!at_keyword(SqlKeyword::When)) return fail();
+
+            Value chosen = Value::null();
+            bool decided = false;
+            bool doubtful = false;
+            Value doubt;
+            while (take_keyword(SqlKeyword::When))
+            {
+                const Value when = or_expression();
+                if (!take_keyword(SqlKeyword::Then)) return fail();
+                const Value then = or_expression();
+                if (decided || doubtful) continue;
+                const Value test = has_base ? compare(base, SqlOperator::Equal, when) : when;
+                switch (truth(test))
+                {
+                case Truth::True:
+                    chosen = then;
+                    decided = true;
+                    break;
+                case Truth::Unknown:
+                    doubt = test;
+                    doubtful = true;
+                    break;
+                default:
+                    break;
+                }
+            }
+            const Value otherwise = take_keyword(SqlKeyword::Else) ? or_expression() : Value::null();
+            if (!take_keyword(SqlKeyword::End)) return fail();
+            if (doubtful) return undecided(doubt, doubt);
+            return decided ? chosen : otherwise;
+        }
+
+        // --- Folding ---
+        static bool constant(const Value& v) noexcept
+        {
+            return v.kind == Value::Kind::Opaque || v.kind == Value::Kind::Null || v.kind == Value::Kind::Number
+                || v.kind == Value::Kind::Text;
+        }
+
+        // The result of an operation the folder does not compute: Opaque from constants alone.
+        static Value undecided(const Value& a, const Value& b) noexcept
+        {
+            return constant(a) && constant(b) ? Value::opaque() : Value::unknown();
+        }
+
+        static Value logical_or(const Value& a, const Value& b) noexcept
+        {
+            const Truth x = truth(a), y = truth(b);
+            if (x == Truth::True || y == Truth::True) return Value::of(true);
+            if (x == Truth::False && y == Truth::False) return Value::of(false);
+            return x == Truth::Unknown || y == Truth::Unknown ? undecided(a, b) : Value::null();
+        }
+
+        static Value logical_and(const Value& a, const Value& b) noexcept
+        {
+            const Truth x = truth(a), y = truth(b);
+            if (x == Truth::False || y == Truth::False) return Value::of(false);
+            if (x == Truth::True && y == Truth::True) return Value::of(true);
+            return x == Truth::Unknown || y == Truth::Unknown ? undecided(a, b) : Value::null();
+        }
+
+        static Value logical_not(const Value& a) noexcept
+        {
+            switch (truth(a))
+            {
+            case Truth::True:  return Value::of(false);
+            case Truth::False: return Value::of(true);
+            case Truth::Null:  return Value::null();
+            default:           return undecided(a, a);
+            }
+        }
+
+        static bool same_column(const Value& a, const Value& b) noexcept
+        {
+            if (a.kind != Value::Kind::Column || b.kind != Value::Kind::Column || a.text.size() != b.text.size()) return false;
+            for (std::size_t i = 0; i < a.text.size(); ++i)
+            {
+                if (SqlLexer::to_lower(a.text[i]) != SqlLexer::to_lower(b.text[i])) return false;
+            }
+            return true;
+        }
+
+        static bool known(const Value& v) noexcept { return v.kind == Value::Kind::Number || v.kind == Value::Kind::Text; }
+
+        // Literals of different types order as SQLite does without affinity: numbers before text.
+        static int order(const Value& a, const Value& b) noexcept
+        {
+            if (a.kind == Value::Kind::Number && b.kind == Value::Kind::Number)
+                return a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+            if (a.kind == Value::Kind::Text && b.kind == Value::Kind::Text) return compare_text(a.text, b.text, a.nocase || b.nocase);
+            return a.kind == Value::Kind::Number ? -1 : 1;
+        }
+
+        static Value compare(const Value& a, SqlOperator op, const Value& b) noexcept
+        {
+            int c = 0;
+            if (!same_column(a, b))
+            {
+                if (a.kind == Value::Kind::Null || b.kind == Value::Kind::Null) return Value::null();
+                if (!known(a) || !known(b)) return undecided(a, b);
+                c = order(a, b);
+            }
+            switch (op)
+            {
+            case SqlOperator::Equal:        return Value::of(c == 0);
+            case SqlOperator::NotEqual:     return Value::of(c != 0);
+            case SqlOperator::Less:         return Value::of(c < 0);
+            case SqlOperator::LessEqual:    return Value::of(c <= 0);
+            case SqlOperator::Greater:      return Value::of(c > 0);
+            case SqlOperator::GreaterEqual: return Value::of(c >= 0);
+            default:                        return undecided(a, b);
+            }
+        }
+
+        static Value is(const Value& a, const Value& b) noexcept
+        {
+            if (same_column(a, b)) return Value::of(true);
+            const bool a_null = a.kind == Value::Kind::Null, b_null = b.kind == Value::Kind::Null;
+            if ((a_null || known(a)) && (b_null || known(b)))
+                return Value::of(a_null || b_null ? a_null == b_null : order(a, b) == 0);
+            return undecided(a, b);
+        }
+
+        static bool all_of(std::string_view text, char c) noexcept
+        {
+            return !text.empty() && text.find_first_not_of(c) == std::string_view::npos;
+        }
+
+        static Value like(const Value& a, const Value& b) noexcept
+        {
+            // "column LIKE '%'" matches every row that has a value
+            if (b.kind == Value::Kind::Text && all_of(b.text, '%') && (a.kind == Value::Kind::Column || a.kind == Value::Kind::Text))
+                return Value::of(true);
+            if (same_column(a, b)) return Value::of(true);
+            if (a.kind == Value::Kind::Null || b.kind == Value::Kind::Null) return Value::null();
+            if (a.kind != Value::Kind::Text || b.kind != Value::Kind::Text) return undecided(a, b);
+            return Value::of(wildcard_match(a.text, b.text, '%', '_', true));
+        }
+
+        // LIKE ... ESCAPE: folded as a plain LIKE when the pattern does not use the escape.
+        static Value like_escaped(const Value& a, const Value& b, const Value& escape) noexcept
+        {
+            if (escape.kind == Value::Kind::Null) return Value::null();
+            if (escape.kind == Value::Kind::Text && escape.text.size() == 1
+                && (b.kind != Value::Kind::Text || b.text.find(escape.text[0]) == std::string_view::npos))
+                return like(a, b);
+            return constant(escape) ? undecided(a, b) : Value::unknown();
+        }
+
+        static Value glob(const Value& a, const Value& b) noexcept
+        {
+            if (b.kind == Value::Kind::Text && all_of(b.text, '*') && (a.kind == Value::Kind::Column || a.kind == Value::Kind::Text))
+                return Value::of(true);
+            if (a.kind == Value::Kind::Null || b.kind == Value::Kind::Null) return Value::null();
+            if (a.kind != Value::Kind::Text || b.kind != Value::Kind::Text || b.text.find('[') != std::string_view::npos)
+                return undecided(a, b);
+            return Value::of(wildcard_match(a.text, b.text, '*', '?', false));
+        }
+
+        static Value arithmetic(const Value& a, SqlOperator op, const Value& b) noexcept
+        {
+            if (a.kind == Value::Kind::Null || b.kind == Value::Kind::Null) return Value::null();
+            if (!known(a) || !known(b)) return undecided(a, b);
+            const Value x = a.kind == Value::Kind::Text ? text_number(a.text) : a;
+            const Value y = b.kind == Value::Kind::Text ? text_number(b.text) : b;
+            const bool integer = x.integer && y.integer;
+            switch (op)
+            {
+            case SqlOperator::Plus:     return Value::of(x.number + y.number, integer);
+            case SqlOperator::Minus:    return Value::of(x.number - y.number, integer);
+            case SqlOperator::Multiply: return Value::of(x.number * y.number, integer);
+            case SqlOperator::Divide:
+                if (y.number == 0.0) return Value::null();
+                return Value::of(x.number / y.number, integer);
+            case SqlOperator::Modulo:
+            {
+                const double divisor = std::trunc(y.number);
+                if (divisor == 0.0) return Value::null();
+                return Value::of(std::fmod(std::trunc(x.number), divisor), integer);
+            }
+            default:
+                return undecided(a, b);
+            }
+        }
+
+        // & | << >> and (with b unused) ~, on the 64-bit integers SQLite converts to.
+        static Value bitwise(const Value& a, std::string_view op, const Value& b) noexcept
+        {
+            const bool unary = op == "~";
+            if (a.kind == Value::Kind::Null || (!unary && b.kind == Value::Kind::Null)) return Value::null();
+            if (!known(a) || (!unary && !known(b))) return undecided(a, unary ? a : b);
+            const double x = a.kind == Value::Kind::Text ? text_number(a.text).number : a.number;
+            const double y = unary ? 0.0 : (b.kind == Value::Kind::Text ? text_number(b.text).number : b.number);
+            if (!(std::fabs(x) < 9.2e18) || !(std::fabs(y) < 9.2e18)) return Value::opaque();
+            const std::int64_t i = static_cast<std::int64_t>(x), j = static_cast<std::int64_t>(y);
+            if (unary) return Value::of(static_cast<double>(~i), true);
+            if (op == "&") return Value::of(static_cast<double>(i & j), true);
+            if (op == "|") return Value::of(static_cast<double>(i | j), true);
+            if (j < 0 || j > 62) return Value::opaque();
+            const std::uint64_t u = static_cast<std::uint64_t>(i);
+            return Value::of(static_cast<double>(op == "<<" ? static_cast<std::int64_t>(u << j) : i >> j), true);
+        }
+
+        // --- Literals ---
+        // What SQLite makes of a decimal outside double's range: infinity, or 0 when it underflows.
+        static double out_of_range(std::string_view digits) noexcept
+        {
+            std::size_t i = 0;
+            while (i < digits.size() && digits[i] == '0') ++i;
+            long magnitude = 0;
+            for (; i < digits.size() && SqlLexer::is_digit(digits[i]); ++i) ++magnitude;
+            if (magnitude == 0 && i < digits.size() && digits[i] == '.')
+            {
+                for (++i; i < digits.size() && digits[i] == '0'; ++i) --magnitude;
+            }
+            while (i < digits.size() && digits[i] != 'e' && digits[i] != 'E') ++i;
+            if (i < digits.size())
+            {
+                ++i;
+                const bool negative = i < digits.size() && digits[i] == '-';
+                if (i < digits.size() && (digits[i] == '-' || digits[i] == '+')) ++i;
+                long exponent = 0;
+                for (; i < digits.size() && SqlLexer::is_digit(digits[i]); ++i)
+                {
+                    exponent = exponent < 100000 ? exponent * 10 + (digits[i] - '0') : exponent;
+                }
+                magnitude += negative ? -exponent : exponent;
+            }
+            return magnitude > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+        }
+
+        static Value number(std::string_view digits) noexcept
+        {
+            if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+            {
+                std::uint64_t value = 0;
+                const auto parsed = std::from_chars(digits.data() + 2, digits.data() + digits.size(), value, 16);
+                return parsed.ec == std::errc() ? Value::of(static_cast<double>(value), true) : Value::opaque();
+            }
+            double value = 0.0;
+            const auto parsed = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            if (parsed.ec == std::errc::result_out_of_range)
+                value = out_of_range(digits);
+            else if (parsed.ec != std::errc())
+                return Value::opaque();
+            return Value::of(value, digits.find_first_of(".eE") == std::string_view::npos);
+        }
+
+        // The number at the start of a text, as SQLite reads it in arithmetic: 0 when there is none.
+        static Value text_number(std::string_view text) noexcept
+        {
+            std::size_t i = 0;
+            while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r')) ++i;
+            bool negative = false;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) negative = text[i++] == '-';
+            std::size_t end = i;
+            while (end < text.size() && (SqlLexer::is_digit(text[end]) || text[end] == '.' || text[end] == 'e' || text[end] == 'E')) ++end;
+            double value = 0.0;
+            const auto parsed = std::from_chars(text.data() + i, text.data() + end, value);
+            if (parsed.ptr == text.data() + i) return Value::of(0.0, true);
+            const std::string_view used = text.substr(i, static_cast<std::size_t>(parsed.ptr - (text.data() + i)));
+            if (parsed.ec == std::errc::result_out_of_range)
+                value = out_of_range(used);
+            else if (parsed.ec != std::errc())
+                return Value::of(0.0, true);
+            return Value::of(negative ? -value : value, used.find_first_of(".eE") == std::string_view::npos);
+        }
+
+        // Byte order of two quoted texts whose '' pairs each stand for one quote.
+        static int compare_text(std::string_view a, std::string_view b, bool nocase) noexcept
+        {
+            std::size_t i = 0, j = 0;
+            while (i < a.size() && j < b.size())
+            {
+                unsigned char x = static_cast<unsigned char>(a[i]), y = static_cast<unsigned char>(b[j]);
+                i += x == '\'' ? 2 : 1;
+                j += y == '\'' ? 2 : 1;
+                if (nocase)
+                {
+                    x = static_cast<unsigned char>(SqlLexer::to_lower(static_cast<char>(x)));
+                    y = static_cast<unsigned char>(SqlLexer::to_lower(static_cast<char>(y)));
+                }
+                if (x != y) return x < y ? -1 : 1;
+            }
+            if (i < a.size()) return 1;
+            return j < b.size() ? -1 : 0;
+        }
+
+        // SQLite's default LIKE (% and _, ASCII case folded) or GLOB (* and ?, exact).
+        static bool wildcard_match(std::string_view text, std::string_view pattern, char run, char one, bool fold) noexcept
+        {
+            std::size_t t = 0, p = 0;
+            std::size_t star = std::string_view::npos, resume = 0;
+            while (t < text.size())
+            {
+                if (p < pattern.size() && pattern[p] == run)
+                {
+                    star = p++;
+                    resume = t;
+                }
+                else if (p < pattern.size()
+                    && (pattern[p] == one || pattern[p] == text[t]
+                        || (fold && SqlLexer::to_lower(pattern[p]) == SqlLexer::to_lower(text[t]))))
+                {
+                    ++t;
+                    ++p;
+                }
+                else if (star != std::string_view::npos)
+                {
+                    p = star + 1;
+                    t = ++resume;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            while (p < pattern.size() && pattern[p] == run) ++p;
+            return p == pattern.size();
+        }
+
+        // --- Token helpers ---
+        std::string_view text(const SqlToken& token) const noexcept { return sql_.substr(token.offset, token.length); }
+
+        // A quoted token without its quotes.
+        std::string_view inner(const SqlToken& token) const noexcept
+        {
+            const std::size_t closer = token.unterminated ? 0 : 1;
+            const std::size_t open = token.kind == SqlTokenKind::Blob ? 2 : 1;
+            if (token.length < open + closer) return std::string_view();
+            return sql_.substr(token.offset + open, token.length - open - closer);
+        }
+
+        bool at_keyword(SqlKeyword keyword) const noexcept { return at_ < count_ && tokens_[at_].keyword == keyword; }
+        bool at_operator(SqlOperator op) const noexcept { return at_ < count_ && tokens_[at_].kind == SqlTokenKind::Operator && tokens_[at_].op == op; }
+
+        bool take_keyword(SqlKeyword keyword) noexcept
+        {
+            if (!at_keyword(keyword)) return false;
+            ++at_;
+            return true;
+        }
+
+        bool take_kind(SqlTokenKind kind) noexcept
+        {
+            if (at_ == count_ || tokens_[at_].kind != kind) return false;
+            ++at_;
+            return true;
+        }
+
+        Value fail() noexcept
+        {
+            failed_ = true;
+            at_ = count_;   // stops every loop above
+            return Value::opaque();
+        }
+
+        const SqlToken* tokens_;
+        std::size_t count_;
+        std::string_view sql_;
+        std::size_t at_ = 0;
+        bool failed_ = false;
+    };
+
+    // Tokens of the OR operand being collected.
+    //
+    // IN lists of literals, which ORMs send with thousands of items, are kept only while the
+    // buffer has room to spare; the items after that are replaced by one blob literal. Folded
+    // against a column the list depends on the data either way, and against a constant the
+    // blob leaves it Opaque, so dropping items never turns a suspect operand clean.
+    class Operand
+    {
+    public:
+        static constexpr std::size_t capacity = 64;
+        static constexpr std::size_t headroom = 16;   // kept free of IN list items for what follows
+
+        void reset() noexcept
+        {
+            count_ = 0;
+            list_ = List::None;
+            pending_count_ = 0;
+        }
+
+        // False when the operand is too long to evaluate, which the caller must treat as suspect.
+        bool push(const SqlToken& token) noexcept
+        {
+            switch (list_)
+            {
+            case List::AfterIn:
+                if (token.kind == SqlTokenKind::LeftParen)
+                {
+                    list_ = List::Item;
+                    elided_ = false;
+                    return store(token);
+                }
+                list_ = List::None;
+                return push(token);
+            case List::Item:
+                if (token.kind == SqlTokenKind::Comma || token.kind == SqlTokenKind::RightParen)
+                {
+                    if (!settle_item()) return false;
+                    if (token.kind == SqlTokenKind::RightParen || list_ == List::None)
+                    {
+                        list_ = List::None;
+                        return store(token);
+                    }
+                    pending_[pending_count_++] = token;
+                    return true;
+                }
+                if (extends_literal(token))
+                {
+                    pending_[pending_count_++] = token;
+                    return true;
+                }
+                // not a list of literals after all: keep the rest as it comes
+                list_ = List::None;
+                if (!flush_pending()) return false;
+                return push(token);
+            default:
+                if (token.keyword == SqlKeyword::In) list_ = List::AfterIn;
+                return store(token);
+            }
+        }
+
+        // Always true, or not shown to depend on the data: see the header comment.
+        bool suspect(std::string_view sql) const noexcept
+        {
+            if (count_ == 0) return false;
+            if (list_ != List::None) return true;   // an IN list without its ')' cannot be folded
+            const Value value = Folder(tokens_, count_, sql).fold();
+            return value.kind == Value::Kind::Opaque || Folder::truth(value) == Folder::Truth::True;
+        }
+
+    private:
+        enum class List : std::uint8_t { None, AfterIn, Item };
+
+        bool store(const SqlToken& token) noexcept
+        {
+            if (count_ == capacity) return false;
+            tokens_[count_++] = token;
+            return true;
+        }
+
+        bool flush_pending() noexcept
+        {
+            for (std::size_t i = 0; i < pending_count_; ++i)
+            {
+                if (!store(pending_[i])) return false;
+            }
+            pending_count_ = 0;
+            return true;
+        }
+
+        static bool literal(const SqlToken& token) noexcept
+        {
+            switch (token.kind)
+            {
+            case SqlTokenKind::Number:
+            case SqlTokenKind::String:
+            case SqlTokenKind::Blob:
+            case SqlTokenKind::Parameter:
+                return true;
+            case SqlTokenKind::Identifier:
+                return token.keyword == SqlKeyword::Null || token.keyword == SqlKeyword::True || token.keyword == SqlKeyword::False;
+            default:
+                return false;
+            }
+        }
+
+        static bool sign(const SqlToken& token) noexcept
+        {
+            return token.kind == SqlTokenKind::Operator && (token.op == SqlOperator::Plus || token.op == SqlOperator::Minus);
+        }
+
+        // Whether token, added to the pending item, keeps it a literal or a signed number.
+        bool extends_literal(const SqlToken& token) const noexcept
+        {
+            const std::size_t first = pending_count_ != 0 && pending_[0].kind == SqlTokenKind::Comma ? 1 : 0;
+            const std::size_t used = pending_count_ - first;
+            if (used == 0) return literal(token) || sign(token);
+            return used == 1 && sign(pending_[first]) && token.kind == SqlTokenKind::Number;
+        }
+
+        // The pending item is complete: keep it while there is room, else stand in one blob
+        // for it and every later item of the list.
+        bool settle_item() noexcept
+        {
+            const bool comma = pending_count_ != 0 && pending_[0].kind == SqlTokenKind::Comma;
+            if (pending_count_ == (comma ? 1 : 0))
+            {
+                list_ = List::None;   // "()" or ",,": leave it to the folder
+                return flush_pending();
+            }
+            if (!elided_ && count_ + pending_count_ + headroom <= capacity) return flush_pending();
+            if (!elided_)
+            {
+                SqlToken blob = pending_[pending_count_ - 1];
+                blob.kind = SqlTokenKind::Blob;
+                blob.keyword = SqlKeyword::None;
+                if (comma && !store(pending_[0])) return false;
+                if (!store(blob)) return false;
+                elided_ = true;
+            }
+            pending_count_ = 0;
+            return true;
+        }
+
+        SqlToken tokens_[capacity];
+        std::size_t count_ = 0;
+        List list_ = List::None;
+        bool elided_ = false;      // this list's blob is already stored
+        SqlToken pending_[3];      // the item being read: [','] [sign] literal
+        std::size_t pending_count_ = 0;
+    };
+
+    // Whether token closes an OR operand when it is not inside the operand's own parentheses
+    // or CASE expressions.
+    inline bool ends_operand(const SqlToken& token) noexcept
+    {
+        switch (token.kind)
+        {
+        case SqlTokenKind::Semicolon:
+        case SqlTokenKind::Comma:
+        case SqlTokenKind::RightParen:
+            return true;
+        case SqlTokenKind::Identifier:
+            switch (token.keyword)
+            {
+            case SqlKeyword::Or:
+            case SqlKeyword::Order:
+            case SqlKeyword::Group:
+            case SqlKeyword::Limit:
+            case SqlKeyword::Union:
+            case SqlKeyword::Except:
+            case SqlKeyword::Intersect:
+            case SqlKeyword::Having:
+            case SqlKeyword::Window:
+            case SqlKeyword::Returning:
+            case SqlKeyword::When:
+            case SqlKeyword::Then:
+            case SqlKeyword::Else:
+            case SqlKeyword::End:
+                return true;
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    }
+
+    // One pass of the lexer over sql, with every rule applied to each token as it comes.
+    inline Findings scan(std::string_view sql) noexcept
+    {
+        Findings findings;
+        SqlLexer lexer(sql);
+        SqlToken batch[64];
+        Operand operand;
+        bool collecting = false;        // inside an OR operand
+        int depth = 0;                  // parentheses opened inside that operand
+        int cases = 0;                  // CASE expressions opened inside that operand
+        bool after_semicolon = false;
+
+        for (std::size_t count = lexer.fill(batch, 64); count != 0; count = lexer.fill(batch, 64))
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const SqlToken& token = batch[i];
+                if (after_semicolon) findings.multiple_statements = true;
+                switch (token.kind)
+                {
+                case SqlTokenKind::Semicolon:
+                    after_semicolon = true;
+                    break;
+                case SqlTokenKind::LineComment:
+                case SqlTokenKind::BlockComment:
+                    findings.comment = true;
+                    continue;   // otherwise whitespace, as far as the operand goes
+                case SqlTokenKind::String:
+                case SqlTokenKind::Blob:
+                case SqlTokenKind::QuotedIdentifier:
+                    if (token.unterminated) findings.unbalanced_quotes = true;
+                    break;
+                default:
+                    break;
+                }
+
+                if (collecting)
+                {
+                    if (depth == 0 && cases == 0 && ends_operand(token))
+                    {
+                        findings.tautology = findings.tautology || operand.suspect(sql);
+                        collecting = false;
+                    }
+                    else
+                    {
+                        if (token.kind == SqlTokenKind::LeftParen) ++depth;
+                        if (token.kind == SqlTokenKind::RightParen) --depth;
+                        if (token.keyword == SqlKeyword::Case) ++cases;
+                        if (token.keyword == SqlKeyword::End && cases > 0) --cases;
+                        if (!operand.push(token))
+                        {
+                            findings.tautology = true;   // too long to fold: fail closed
+                            collecting = false;
+                        }
+                    }
+                }
+                if (!collecting && token.keyword == SqlKeyword::Or)
+                {
+                    operand.reset();
+                    collecting = true;
+                    depth = 0;
+                    cases = 0;
+                }
+            }
+        }
+        if (collecting) findings.tautology = findings.tautology || operand.suspect(sql);
+        return findings;
+    }
+}
@@ -0,0 +1,169 @@
+// SqlRulesTest.cpp : Table-driven check of the SqlRules injection verdicts.
+//
+// Every row is a query and the verdict InjectionDetector::check() must give it: known
+// bypasses of the earlier matchers, the false positives the token rules fixed, and the
+// fail-closed cases (operands too long to fold, constants the folder cannot compute).
+// Long IN lists, too long to write out in the table, are built by generated_cases(). Prints each mismatch and exits non-zero when there is one. Run by ctest (test sql_rules).
+//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "InjectionDetector.h"
+
+namespace
+{
+    struct Case
+    {
+        const char* sql;
+        InjectionVerdict expected;
+    };
+
+    constexpr InjectionVerdict clean = InjectionVerdict::Clean;
+    constexpr InjectionVerdict statements = InjectionVerdict::MultipleStatements;
+    constexpr InjectionVerdict comment = InjectionVerdict::CommentToken;
+    constexpr InjectionVerdict tautology = InjectionVerdict::Tautology;
+    constexpr InjectionVerdict quotes = InjectionVerdict::UnbalancedQuotes;
+
+    // "(<first>, ..., <first + count - 1>)", each number formatted with item.
+    std::string in_list(int first, int count, const char* item = "%d")
+    {
+        std::string list = "(";
+        char text[32];
+        for (int i = 0; i < count; ++i)
+        {
+            std::snprintf(text, sizeof(text), item, first + i);
+            list += (i == 0 ? "" : ", ");
+            list += text;
+        }
+        return list + ")";
+    }
+
+    struct GeneratedCase
+    {
+        std::string sql;
+        InjectionVerdict expected;
+    };
+
+    // ORM-style IN lists far longer than the operand buffer.
+    std::vector<GeneratedCase> generated_cases()
+    {
+        const std::string ids = in_list(0, 200);
+        const std::string names = in_list(0, 200, "'name%d'");
+        return {
+            { "SELECT * FROM USERS WHERE NAME='x' OR ID IN " + ids, clean },
+            { "SELECT * FROM USERS WHERE ID IN " + ids + " OR NAME IN " + names, clean },
+            { "SELECT * FROM USERS WHERE ID IN " + ids + " OR ID NOT IN " + in_list(-200, 200) + " AND NAME IN " + names, clean },
+            { "SELECT * FROM USERS WHERE NAME='x' OR ID IN " + in_list(0, 200, "?"), clean },
+            { "SELECT * FROM USERS WHERE NAME='x' OR ID IN " + ids + " OR 1=1", tautology },
+            { "SELECT * FROM USERS WHERE NAME='x' OR (ID IN " + ids + " OR 1=1)", tautology },
+            { "SELECT * FROM USERS WHERE NAME='x' OR 199 IN " + ids, tautology },     // found among the dropped items
+            { "SELECT * FROM USERS WHERE NAME='x' OR 'a' IN " + names, tautology },   // a constant left side fails closed
+            { "SELECT * FROM USERS WHERE NAME='x' OR ID IN " + ids.substr(0, ids.size() - 1), tautology },   // no ')'
+        };
+    }
+
+    const Case cases[] = {
+        // the program's own queries
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred'", clean },
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 1=1;", tautology },
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 2=2;", tautology },
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 'hi'='hi';", tautology },
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 'hack'='hack';", tautology },
+        { "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME='Fred' or 'one'='one';", tautology },
+
+        // tautologies the substring matcher missed
+        { "SELECT * FROM USERS WHERE NAME='x' or 3>2", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or name=name", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or (1=1)", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or not 0", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or true", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 2-1=1", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 7/2=3", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1='1'", clean },   // 1 and '1' differ without affinity
+        { "SELECT * FROM USERS WHERE NAME='x' or 'a' like '%'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or name like '%'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or name glob '*'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 'abc' glob 'a?c'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 2 between 1 and 3", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1 in (3,1)", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or null is null", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1=1 and 'a'='a'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or id=3 or 1=1 order by id", tautology },
+        { "SELECT * FROM USERS WHERE (NAME='x' or 1=1) and id=2", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x'or'1'='1'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 'a'<>'b'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1|0", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or ~0", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 'A'='a' collate nocase", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or case when 1 then 1 end", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or case name when name then 1 else 0 end", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1 notnull", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1 not null", tautology },
+
+        // fail closed: too long to fold, out of double's range, or constants the folder cannot compute
+        { "SELECT * FROM USERS WHERE NAME='Fred' or 1=1 and 1=1 and 1=1 and 1=1 and 1=1 and 1=1 and 1=1 and 1=1 and 1=1", tautology },
+        { "SELECT * FROM USERS WHERE NAME='Fred' or id=1 and id=1 and id=1 and id=1 and id=1 and id=1 and id=1 and id=1"
+          " and id=1 and id=1 and id=1 and id=1 and id=1 and id=1 and id=1 and id=1 and id=1", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1e400", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or -1e400", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or '1e400'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1e-400", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or 'a'||'b'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or abs(1)=1", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or (select 1)", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or x'01'", tautology },
+        { "SELECT * FROM USERS WHERE NAME='x' or name is distinct from 'y'", tautology },
+
+        // data-dependent operands stay clean
+        { "SELECT * FROM USERS WHERE NAME='Fred' or 1=2", clean },
+        { "SELECT * FROM USERS WHERE NAME='Fred' or name='Barney'", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1=1 and id=3", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or null=null", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or id is not null", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or name glob 'F*'", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or name like 'F%' escape '!'", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or upper(name)='FRED'", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or id in (select id from admins)", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or name = ?", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or case when id > 2 then 1 else 0 end", clean },
+        { "SELECT * FROM USERS WHERE NAME='x' or name collate nocase = 'fred'", clean },
+        { "SELECT COUNT(*) FROM USERS GROUP BY NAME HAVING NAME='x' or count(*) > 1", clean },
+        { "SELECT * FROM USERS WHERE 1=1", clean },   // no OR operand
+
+        // literals are data, not code
+        { "SELECT * FROM USERS WHERE NAME='a--b'", clean },
+        { "SELECT * FROM USERS WHERE NAME='a;b'", clean },
+        { "SELECT * FROM USERS WHERE NAME='a or 1=1'", clean },
+        { "SELECT * FROM USERS WHERE NAME='O''Brien'", clean },
+
+        // the other rules
+        { "SELECT * FROM USERS WHERE NAME='Fred' -- x", comment },
+        { "SELECT * FROM USERS WHERE NAME='Fred' /* x */", comment },
+        { "SELECT * FROM USERS WHERE NAME='x' or 1=1 --", comment },
+        { "SELECT * FROM USERS WHERE NAME='Fred'; DROP TABLE USERS", statements },
+        { "SELECT * FROM USERS WHERE NAME='Fred';", clean },
+        { "SELECT * FROM USERS WHERE NAME='Fred", quotes },
+    };
+}
+
+int main()
+{
+    int failures = 0;
+    std::size_t total = 0;
+    const auto check = [&](const char* sql, InjectionVerdict expected) {
+        ++total;
+        const InjectionVerdict got = InjectionDetector::verdict(sql_rules::scan(sql));
+        if (got != expected)
+        {
+            std::printf("FAIL %s\n     expected %s, got %s\n", sql, describe(expected), describe(got));
+            ++failures;
+        }
+    };
+    for (const Case& c : cases) check(c.sql, c.expected);
+    for (const GeneratedCase& c : generated_cases()) check(c.sql.c_str(), c.expected);
+    std::printf("%zu of %zu cases passed\n", total - static_cast<std::size_t>(failures), total);
+    return failures == 0 ? 0 : 1;
+}
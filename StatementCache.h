@@ -0,0 +1,129 @@
+// StatementCache.h : LRU cache of prepared sqlite3_stmt* handles keyed by SQL template.
+//
+// sqlite3_exec parses and plans the SQL text on every call. A template such as
+// "SELECT ID, NAME, PASSWORD FROM USERS WHERE NAME=?" only needs to be prepared once;
+// repeat calls reset the cached statement and bind new parameter values.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "sqlite3.h"
+
+class StatementCache
+{
+public:
+    explicit StatementCache(sqlite3* db, std::size_t capacity = 16)
+        : db_(db), capacity_(capacity == 0 ? 1 : capacity)
+    {
+    }
+
+    ~StatementCache()
+    {
+        clear();
+    }
+
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    // Returns the cached statement for this template, reset and with its bindings
+    // cleared, or nullptr when the template has not been prepared yet.
+    sqlite3_stmt* find(std::string_view sql_template)
+    {
+        auto it = index_.find(sql_template);
+        if (it == index_.end())
+        {
+            ++misses_;
+            return nullptr;
+        }
+        ++hits_;
+        return touch(it->second);
+    }
+
+    // Prepares the template and caches it, evicting the least recently used
+    // statement when full. Returns nullptr if SQLite cannot prepare the text;
+    // sqlite3_errmsg(db) then describes why.
+    sqlite3_stmt* prepare(const std::string& sql_template)
+    {
+        auto it = index_.find(sql_template);
+        if (it != index_.end()) return touch(it->second);
+
+        sqlite3_stmt* stmt = NULL;
+        if (sqlite3_prepare_v3(db_, sql_template.c_str(), static_cast<int>(sql_template.size()),
+                SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK || stmt == NULL)
+        {
+            sqlite3_finalize(stmt);
+            return nullptr;
+        }
+
+        if (lru_.size() >= capacity_)
+        {
+            index_.erase(lru_.back().sql);
+            sqlite3_finalize(lru_.back().stmt);
+            lru_.pop_back();
+        }
+
+        lru_.push_front(Entry{ sql_template, stmt });
+        index_.emplace(lru_.front().sql, lru_.begin());
+        return stmt;
+    }
+
+    // Finalizes every cached statement.
+    void clear()
+    {
+        for (auto& entry : lru_)
+        {
+            sqlite3_finalize(entry.stmt);
+        }
+        index_.clear();
+        lru_.clear();
+    }
+
+    sqlite3* database() const { return db_; }
+    std::size_t size() const { return lru_.size(); }
+    std::size_t capacity() const { return capacity_; }
+    std::size_t hits() const { return hits_; }
+    std::size_t misses() const { return misses_; }
+
+private:
+    struct Entry
+    {
+        std::string sql;
+        sqlite3_stmt* stmt;
+    };
+
+    // Marks the entry most recently used and readies its statement for new bindings.
+    sqlite3_stmt* touch(std::list<Entry>::iterator entry)
+    {
+        lru_.splice(lru_.begin(), lru_, entry);
+        sqlite3_reset(entry->stmt);
+        sqlite3_clear_bindings(entry->stmt);
+        return entry->stmt;
+    }
+
+    sqlite3* db_;
+    std::size_t capacity_;
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+    std::list<Entry> lru_;  // front = most recently used
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;  // keys point into lru_ nodes
+};
+
+// Binds each value as text to the 1-based parameters of stmt. The values must stay
+// alive until the statement has been stepped (SQLITE_STATIC avoids a copy).
+inline int bind_text_parameters(sqlite3_stmt* stmt, const std::vector<std::string>& params)
+{
+    for (std::size_t i = 0; i < params.size(); ++i)
+    {
+        int rc = sqlite3_bind_text(stmt, static_cast<int>(i + 1), params[i].data(),
+            static_cast<int>(params[i].size()), SQLITE_STATIC);
+        if (rc != SQLITE_OK) return rc;
+    }
+    return SQLITE_OK;
+}
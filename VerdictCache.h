@@ -0,0 +1,128 @@
+// VerdictCache.h : Bounded, thread-safe cache of injection verdicts keyed by SQL text.
+//
+// run_query and run_query_injection see the same few SQL strings over and over.
+// Remembering the verdict for each text lets identical queries skip the heuristics.
+// The cache is split into shards, each with its own mutex and a fixed number of
+// direct-mapped slots, so concurrent callers rarely contend and memory stays bounded.
+// Slots keep the full text next to its hash; a hash collision can therefore never
+// hand one query another query's verdict.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "InjectionDetector.h"
+
+class VerdictCache
+{
+public:
+    // capacity is rounded up to a whole number of slots per shard. Texts longer than
+    // max_text_length are never cached (scanning them is cheap next to hashing them).
+    explicit VerdictCache(std::size_t capacity = 4096, std::size_t max_text_length = 4096)
+        : slots_per_shard_(capacity / shard_count + (capacity % shard_count != 0 ? 1 : 0)),
+          max_text_length_(max_text_length),
+          shards_(shard_count)
+    {
+        if (slots_per_shard_ == 0) slots_per_shard_ = 1;
+        for (auto& shard : shards_) shard.slots.resize(slots_per_shard_);
+    }
+
+    VerdictCache(const VerdictCache&) = delete;
+    VerdictCache& operator=(const VerdictCache&) = delete;
+
+    // Returns the cached verdict for sql, or runs check(sql), caches and returns its verdict.
+    template <typename Check>
+    InjectionVerdict get_or_check(std::string_view sql, Check&& check)
+    {
+        if (sql.size() > max_text_length_)
+        {
+            bypassed_.fetch_add(1, std::memory_order_relaxed);
+            return check(sql);
+        }
+
+        const std::uint64_t hash = std::hash<std::string_view>()(sql);
+        Shard& shard = shards_[hash % shard_count];
+        Slot& slot = shard.slots[(hash / shard_count) % slots_per_shard_];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (slot.used && slot.hash == hash && slot.text == sql)
+            {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return slot.verdict;
+            }
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        const InjectionVerdict verdict = check(sql);  // outside the lock
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        slot.hash = hash;
+        slot.text.assign(sql.data(), sql.size());  // reuses the slot's buffer when it fits
+        slot.verdict = verdict;
+        slot.used = true;
+        return verdict;
+    }
+
+    // Forgets every verdict (the counters are kept).
+    void clear()
+    {
+        for (auto& shard : shards_)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto& slot : shard.slots) slot.used = false;
+        }
+    }
+
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    std::uint64_t bypassed() const { return bypassed_.load(std::memory_order_relaxed); }
+    std::size_t capacity() const { return slots_per_shard_ * shard_count; }
+
+private:
+    static constexpr std::size_t shard_count = 16;
+
+    struct Slot
+    {
+        std::uint64_t hash = 0;
+        std::string text;
+        InjectionVerdict verdict = InjectionVerdict::Clean;
+        bool used = false;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+    };
+
+    std::size_t slots_per_shard_;
+    std::size_t max_text_length_;
+    std::vector<Shard> shards_;
+    std::atomic<std::uint64_t> hits_{ 0 };
+    std::atomic<std::uint64_t> misses_{ 0 };
+    std::atomic<std::uint64_t> bypassed_{ 0 };
+};
+
+// The process-wide verdict cache in front of shared_injection_detector().
+inline VerdictCache& shared_verdict_cache()
+{
+    static VerdictCache cache;
+    return cache;
+}
+
+// Injection check used by every query path: served from the verdict cache when the same
+// text has been seen before.
+inline InjectionVerdict cached_injection_check(std::string_view sql)
+{
+    return shared_verdict_cache().get_or_check(sql, [](std::string_view text) {
+        return shared_injection_detector().check(text);
+        });
+}
@@ -4,20 +4,22 @@
 #include <iostream>
 #include <stdexcept>
 #include <exception>
-#include <string>
 
-// A custom exception class derived from std::exception
-class CustomException : public std::exception {
-public:
-    const char* what() const noexcept override {
-        return "Custom Exception Thrown!";
-    }
-};
+#include "EventLog.h"         // exceptions that reach main are also logged as events
+#include "ExceptionTypes.h"   // Error, Result<T>, CustomException hierarchy, profiler macros
 
-bool do_even_more_custom_application_logic() {
+// Non-throwing form: reports the failure as an Error.
+Result<bool> try_do_even_more_custom_application_logic() noexcept {
     std::cout << "Running Even More Custom Application Logic." << std::endl;
-    throw std::runtime_error("Something went wrong in even more custom logic.");
-    return true;
+    return logic_failed_error;
+}
+
+bool do_even_more_custom_application_logic() {
+    const Result<bool> result = try_do_even_more_custom_application_logic();
+    if (!result) {
+        throw_error(result.error());
+    }
+    return *result;
 }
 
 void do_custom_application_logic() {
@@ -29,21 +31,31 @@ void do_custom_application_logic() {
         }
     }
     catch (const std::exception& e) {
+        PROFILE_CATCH(e);
         std::cerr << "Caught an exception: " << e.what() << std::endl;
     }
 
-    throw CustomException();
+    PROFILED_THROW(CustomException);
 
     std::cout << "Leaving Custom Application Logic." << std::endl;
 }
 
-float divide(float num, float den) {
+// Non-throwing form of divide: a zero denominator is returned as an Error.
+Result<float> try_divide(float num, float den) noexcept {
     if (den == 0) {
-        throw std::invalid_argument("Division by zero is not allowed.");
+        return division_by_zero_error;
     }
     return (num / den);
 }
 
+float divide(float num, float den) {
+    const Result<float> result = try_divide(num, den);
+    if (!result) {
+        PROFILED_THROW(DivisionByZeroException, num);
+    }
+    return *result;
+}
+
 void do_division() noexcept {
     float numerator = 10.0f;
     float denominator = 0;
@@ -52,26 +64,48 @@ void do_division() noexcept {
         auto result = divide(numerator, denominator);
         std::cout << "divide(" << numerator << ", " << denominator << ") = " << result << std::endl;
     }
-    catch (const std::invalid_argument& e) {
+    catch (const DivisionByZeroException& e) {
+        PROFILE_CATCH(e);
         std::cerr << "Caught a specific exception: " << e.what() << std::endl;
     }
 }
 
+void do_division_without_exceptions() noexcept {
+    float numerator = 10.0f;
+    float denominator = 0;
+
+    const Result<float> result = try_divide(numerator, denominator);
+    if (result) {
+        std::cout << "try_divide(" << numerator << ", " << denominator << ") = " << *result << std::endl;
+    }
+    else {
+        std::cerr << "try_divide failed: " << result.error().message << std::endl;
+    }
+}
+
 int main() {
     std::cout << "Exceptions Tests!" << std::endl;
 
     try {
         do_division();
+        do_division_without_exceptions();
         do_custom_application_logic();
     }
     catch (const CustomException& e) {
+        PROFILE_CATCH(e);
         std::cerr << "Caught my custom exception: " << e.what() << std::endl;
+        EVENT_ERROR("exception_caught", event_log::field("type", "CustomException"),
+            event_log::field("code", static_cast<int>(e.code())), event_log::field("what", e.what()));
     }
     catch (const std::exception& e) {
+        PROFILE_CATCH(e);
         std::cerr << "Caught a standard exception: " << e.what() << std::endl;
+        EVENT_ERROR("exception_caught", event_log::field("type", "std::exception"), event_log::field("what", e.what()));
     }
     catch (...) {
+        PROFILE_CATCH_ALL();
         std::cerr << "Caught an unknown exception." << std::endl;
+        EVENT_ERROR("exception_caught", event_log::field("type", "unknown"));
     }
 
     return 0;
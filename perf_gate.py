@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""perf_gate.py : Performance regression gate for the CS 405 benchmark suites.
+
+Runs the benchmark programs of a CMake build, takes the median of several repetitions of
+every benchmark, and compares it with the baseline stored in perf_baselines.json. The gate
+fails when a median is slower than its baseline by more than the threshold (the file's
+default, a per-benchmark override, or --threshold) and by more than min_delta_ns, so
+nanosecond-scale benchmarks do not fail on timer noise. It also reads a cppcheck XML report
+and fails when it holds more performance-class findings of an id than the baseline accepts.
+
+Suites (skipped with a notice when their program was not built):
+    numeric        numeric_overflow --bench (checked arithmetic), ns per call
+    sql_injection  sql_injection_benchmark (injection checks, run_query, row building)
+    exceptions     exceptions_benchmark (throwing vs Result paths)
+
+Usage:
+    python3 perf_gate.py --build-dir _build/release                # check
+    python3 perf_gate.py --build-dir _build/release --update       # record new baselines
+    python3 perf_gate.py --cppcheck-only                           # just the XML report
+
+Exit status: 0 pass, 1 regression or new cppcheck findings, 2 bad usage or a failed run.
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ET
+
+REPO = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_BASELINES = os.path.join(REPO, "perf_baselines.json")
+DEFAULT_CPPCHECK = os.path.join(REPO, "Static Code analysis.xml")
+DEFAULT_THRESHOLD = 0.25
+DEFAULT_MIN_DELTA_NS = 5.0   # slowdowns smaller than this are timer noise, whatever the ratio
+
+# cppcheck ids that are performance problems whatever severity the report gives them.
+PERFORMANCE_IDS = {
+    "passedByValue",
+    "postfixOperator",
+    "useInitializationList",
+    "redundantCopy",
+    "redundantCopyLocalConst",
+    "stlSize",
+    "useStlAlgorithm",
+    "returnStdMoveLocal",
+    "accessMoved",
+    "iterateByValue",
+    "functionStatic",
+    "stlcstrParam",
+    "stlcstrReturn",
+}
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def executable(build_dir, name):
+    for candidate in (name, name + ".exe", os.path.join("Release", name + ".exe")):
+        path = os.path.join(build_dir, candidate)
+        if os.path.isfile(path):
+            return path
+    return None
+
+
+def run(command):
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    if result.returncode != 0:
+        raise RuntimeError("%s failed (%d):\n%s" % (" ".join(command), result.returncode, result.stderr[-2000:]))
+    return result.stdout
+
+
+def numeric_suite(program, repetitions, args):
+    """Medians of numeric_overflow --bench, which runs each measurement once per call."""
+    samples = {}
+    for _ in range(repetitions):
+        with tempfile.TemporaryDirectory() as scratch:
+            out = os.path.join(scratch, "numeric.json")
+            run([program, "--bench", "--format=json", "--out=" + out,
+                 "--steps=" + args.numeric_steps, "--min-time-ms=" + str(args.numeric_min_time_ms)])
+            with open(out) as f:
+                report = json.load(f)
+        for record in report["benchmarks"]:
+            name = "numeric/%s/%s/%s/%s" % (record["type"], record["operation"], record["variant"], record["steps"])
+            samples.setdefault(name, []).append(float(record["ns_per_call"]))
+    return {name: statistics.median(values) for name, values in samples.items()}
+
+
+def google_suite(suite, program, repetitions, args):
+    """Medians reported by a Google Benchmark program, in ns."""
+    command = [program, "--benchmark_format=json", "--benchmark_repetitions=%d" % repetitions,
+               "--benchmark_report_aggregates_only=true", "--benchmark_min_time=%g" % args.min_time]
+    if args.filter:
+        command.append("--benchmark_filter=" + args.filter)
+    report = json.loads(run(command))
+    medians = {}
+    for record in report["benchmarks"]:
+        if record.get("run_type") != "aggregate" or record.get("aggregate_name") != "median":
+            continue
+        scale = TIME_UNITS.get(record.get("time_unit", "ns"), 1.0)
+        medians["%s/%s" % (suite, record["run_name"])] = float(record["cpu_time"]) * scale
+    return medians
+
+
+def measure(args):
+    suites = [s.strip() for s in args.suites.split(",") if s.strip()]
+    programs = {"numeric": "numeric_overflow", "sql_injection": "sql_injection_benchmark",
+                "exceptions": "exceptions_benchmark"}
+    medians = {}
+    for suite in suites:
+        if suite not in programs:
+            raise ValueError("unknown suite " + suite)
+        program = executable(args.build_dir, programs[suite])
+        if program is None:
+            print("skipping %s: %s is not built in %s" % (suite, programs[suite], args.build_dir))
+            continue
+        print("running %s (%d repetitions)..." % (suite, args.repetitions), flush=True)
+        if suite == "numeric":
+            medians.update(numeric_suite(program, args.repetitions, args))
+        else:
+            medians.update(google_suite(suite, program, args.repetitions, args))
+    return medians
+
+
+def cppcheck_findings(path):
+    """Performance-class findings of a cppcheck XML (version 2) report, by id."""
+    findings = {}
+    root = ET.parse(path).getroot()
+    for error in root.iter("error"):
+        error_id = error.get("id", "")
+        if error.get("severity") != "performance" and error_id not in PERFORMANCE_IDS:
+            continue
+        location = error.find("location")
+        where = "%s:%s" % (location.get("file"), location.get("line")) if location is not None else "?"
+        findings.setdefault(error_id, []).append((where, error.get("msg", "")))
+    return findings
+
+
+def check_cppcheck(findings, accepted):
+    failed = False
+    for error_id in sorted(findings):
+        items = findings[error_id]
+        allowed = int(accepted.get(error_id, 0))
+        status = "NEW" if len(items) > allowed else "accepted"
+        failed = failed or len(items) > allowed
+        print("cppcheck %-24s %d finding(s), %d accepted  %s" % (error_id, len(items), allowed, status))
+        for where, message in items:
+            print("    %s: %s" % (where, message))
+    return not failed
+
+
+def check_benchmarks(medians, baselines, threshold_override):
+    default_threshold = baselines.get("threshold", DEFAULT_THRESHOLD)
+    min_delta_ns = baselines.get("min_delta_ns", DEFAULT_MIN_DELTA_NS)
+    recorded = baselines.get("benchmarks", {})
+    regressions = 0
+    for name in sorted(medians):
+        now = medians[name]
+        entry = recorded.get(name)
+        if entry is None:
+            print("  new        %-60s %12.2f ns" % (name, now))
+            continue
+        threshold = threshold_override if threshold_override is not None else entry.get("threshold", default_threshold)
+        base = float(entry["median_ns"])
+        change = (now - base) / base if base > 0 else 0.0
+        regressed = change > threshold and now - base > min_delta_ns
+        regressions += regressed
+        print("  %-10s %-60s %12.2f ns  baseline %12.2f ns  %+6.1f%% (limit %+.0f%%)"
+              % ("REGRESSED" if regressed else "ok", name, now, base, change * 100, threshold * 100))
+    for name in sorted(set(recorded) - set(medians)):
+        print("  not run    %s" % name)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0], formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default=os.path.join(REPO, "_build", "release"), help="CMake build directory with the programs")
+    parser.add_argument("--baselines", default=DEFAULT_BASELINES, help="baseline JSON file (default perf_baselines.json)")
+    parser.add_argument("--threshold", type=float, help="allowed slowdown as a fraction, overriding the baseline file")
+    parser.add_argument("--repetitions", type=int, default=5, help="runs per benchmark; the median is compared")
+    parser.add_argument("--suites", default="numeric,sql_injection,exceptions", help="comma-separated suites to run")
+    parser.add_argument("--filter", help="Google Benchmark --benchmark_filter regex")
+    parser.add_argument("--min-time", type=float, default=0.05, help="Google Benchmark minimum time per run, seconds")
+    parser.add_argument("--numeric-steps", default="1000", help="--steps for numeric_overflow --bench")
+    parser.add_argument("--numeric-min-time-ms", type=float, default=10, help="--min-time-ms for numeric_overflow --bench")
+    parser.add_argument("--cppcheck", default=DEFAULT_CPPCHECK, help="cppcheck XML report to check ('' to skip)")
+    parser.add_argument("--cppcheck-only", action="store_true", help="check the cppcheck report and nothing else")
+    parser.add_argument("--update", action="store_true", help="write the measured medians (and cppcheck counts) as the baselines")
+    args = parser.parse_args()
+
+    baselines = {"threshold": DEFAULT_THRESHOLD, "min_delta_ns": DEFAULT_MIN_DELTA_NS, "benchmarks": {}, "cppcheck_accepted": {}}
+    if os.path.isfile(args.baselines):
+        with open(args.baselines) as f:
+            baselines.update(json.load(f))
+
+    findings = {}
+    if args.cppcheck:
+        if not os.path.isfile(args.cppcheck):
+            print("cppcheck report %s not found" % args.cppcheck)
+            return 2
+        findings = cppcheck_findings(args.cppcheck)
+
+    medians = {}
+    if not args.cppcheck_only:
+        try:
+            medians = measure(args)
+        except (RuntimeError, ValueError, OSError, KeyError, json.JSONDecodeError) as error:
+            print("benchmark run failed: %s" % error)
+            return 2
+
+    if args.update:
+        recorded = baselines.setdefault("benchmarks", {})
+        for name, value in medians.items():
+            entry = recorded.setdefault(name, {})
+            entry["median_ns"] = round(value, 3)
+        if args.cppcheck:
+            baselines["cppcheck_accepted"] = {error_id: len(items) for error_id, items in sorted(findings.items())}
+        with open(args.baselines, "w") as f:
+            json.dump(baselines, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("wrote %d baselines to %s" % (len(medians), args.baselines))
+        return 0
+
+    ok = True
+    if args.cppcheck:
+        ok = check_cppcheck(findings, baselines.get("cppcheck_accepted", {})) and ok
+    if medians:
+        regressions = check_benchmarks(medians, baselines, args.threshold)
+        if regressions:
+            print("%d benchmark(s) regressed" % regressions)
+            ok = False
+    print("perf gate: %s" % ("PASS" if ok else "FAIL"))
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())